@@ -321,6 +321,8 @@ typedef void (MDB_rel_func)(MDB_val *item, void *oldptr, void *newptr, void *rel
 #define MDB_INTEGERDUP	0x20
 	/** with #MDB_DUPSORT, use reverse string dups */
 #define MDB_REVERSEDUP	0x40
+	/** store shortest separators instead of full keys on branch pages */
+#define MDB_SHORTSEP	0x80
 	/** create DB if not already existing */
 #define MDB_CREATE		0x40000
 /** @} */
@@ -473,6 +475,17 @@ typedef struct MDB_envinfo {
 	unsigned int me_numreaders;		/**< max reader slots used in the environment */
 } MDB_envinfo;
 
+/** @brief Dirty page counters of a write transaction, see #mdb_txn_dirty_stat() */
+typedef struct MDB_dirty_stat {
+	size_t	ds_dirty;		/**< pages in the dirty list now */
+	size_t	ds_peak;		/**< most pages the dirty list held */
+	size_t	ds_room;		/**< pages left before the txn must spill */
+	size_t	ds_max;			/**< dirty list limit, see #mdb_env_set_dirty_max() */
+	size_t	ds_spills;		/**< times dirty pages were spilled */
+	size_t	ds_spilled;		/**< pages written by those spills */
+	size_t	ds_unspilled;	/**< spilled pages read back to be changed again */
+} MDB_dirty_stat;
+
 	/** @brief Return the LMDB library version information.
 	 *
 	 * @param[out] major if non-NULL, the library major version number is copied here
@@ -919,6 +932,51 @@ int  mdb_env_set_userctx(MDB_env *env, void *ctx);
 	 */
 void *mdb_env_get_userctx(MDB_env *env);
 
+	/** @brief Write commits through io_uring.
+	 *
+	 * By default a commit writes its dirty pages with one pwritev() per
+	 * run of up to 64 adjacent pages and waits for each. Then it calls
+	 * fdatasync(). With a ring, all runs are queued up to \b depth at a
+	 * time, and the data sync is queued behind them (IOSQE_IO_DRAIN), so a
+	 * large commit takes a few io_uring_enter() calls. The meta page is
+	 * still written after that, as before. Environments opened with
+	 * #MDB_WRITEMAP do not write pages and are unaffected. Only available
+	 * on Linux. If the kernel refuses the ring, the error is returned and
+	 * commits keep the pwritev() path.
+	 * @param[in] env An environment handle returned by #mdb_env_create()
+	 * @param[in] depth Runs kept in flight, 0 to go back to pwritev().
+	 * @return A non-zero error value on failure and 0 on success. Some
+	 * possible errors are:
+	 * <ul>
+	 *	<li>EINVAL - a write transaction is active.
+	 *	<li>ENOSYS - built without io_uring, or the kernel lacks it.
+	 *	<li>EPERM - io_uring is disabled for this process.
+	 * </ul>
+	 */
+int  mdb_env_set_uring(MDB_env *env, unsigned int depth);
+
+	/** @brief Let write transactions dirty more pages before spilling.
+	 *
+	 * A write transaction keeps its dirty pages in memory until commit.
+	 * By default it holds at most 2^17 of them (512MB of 4K pages). Past
+	 * that, #mdb_put() and friends write some of them to the map early
+	 * ("spill") and read them back if they are touched again, so very
+	 * large transactions get slower and write some pages twice. With a
+	 * larger limit the dirty list doubles on demand up to \b pages, and
+	 * only then spills. The grown list is kept for later transactions.
+	 * Nested transactions are not supported in this mode, #mdb_txn_begin()
+	 * with a parent returns #MDB_INCOMPATIBLE. The pages are held in
+	 * process memory, size the limit to fit.
+	 * @param[in] env An environment handle returned by #mdb_env_create()
+	 * @param[in] pages The limit, at least 2^17, or 0 for the default.
+	 * @return A non-zero error value on failure and 0 on success. Some
+	 * possible errors are:
+	 * <ul>
+	 *	<li>EINVAL - a write transaction is active, or the limit is out of range.
+	 * </ul>
+	 */
+int  mdb_env_set_dirty_max(MDB_env *env, size_t pages);
+
 	/** @brief A callback function for most LMDB assert() failures,
 	 * called before printing the message and aborting.
 	 *
@@ -989,6 +1047,19 @@ MDB_env *mdb_txn_env(MDB_txn *txn);
 	 */
 size_t mdb_txn_id(MDB_txn *txn);
 
+	/** @brief Return the dirty page counters of a write transaction.
+	 *
+	 * @param[in] txn A write transaction handle returned by #mdb_txn_begin()
+	 * @param[out] stat The address of an #MDB_dirty_stat structure
+	 * 	where the counters will be copied
+	 * @return A non-zero error value on failure and 0 on success. Some
+	 * possible errors are:
+	 * <ul>
+	 *	<li>EINVAL - an invalid parameter was specified, or txn is read-only.
+	 * </ul>
+	 */
+int  mdb_txn_dirty_stat(MDB_txn *txn, MDB_dirty_stat *stat);
+
 	/** @brief Commit all the operations of a transaction into the database.
 	 *
 	 * The transaction handle is freed. It and its cursors must not be used
@@ -1112,6 +1183,15 @@ int  mdb_txn_renew(MDB_txn *txn);
 	 *	<li>#MDB_REVERSEDUP
 	 *		This option specifies that duplicate data items should be compared as
 	 *		strings in reverse order.
+	 *	<li>#MDB_SHORTSEP
+	 *		When a leaf page splits, the key pushed up to the parent branch page
+	 *		is cut down to the shortest prefix of the right page's first key
+	 *		that still sorts after the left page's last key. Long keys that share
+	 *		a prefix then take less room on branch pages, which raises fanout and
+	 *		can lower the tree depth. Only applies to the default lexical key
+	 *		order. The on-disk format is unchanged, a database created with this
+	 *		flag can be read and written by versions that do not know it.
+	 *		Like the other database flags it only takes effect on creation.
 	 *	<li>#MDB_CREATE
 	 *		Create the named database if it doesn't exist. This option is not
 	 *		allowed in a read-only transaction or a read-only environment.
@@ -1150,6 +1230,44 @@ int  mdb_stat(MDB_txn *txn, MDB_dbi dbi, MDB_stat *stat);
 	 */
 int mdb_dbi_flags(MDB_txn *txn, MDB_dbi dbi, unsigned int *flags);
 
+	/** @brief mlock() the pages instead of only advising them, see #mdb_dbi_warmup() */
+#define MDB_WARMUP_LOCK	0x01
+
+	/** @brief Bring the branch pages of a database into memory.
+	 *
+	 * Walks the tree one level at a time from the root. Each level is first
+	 * passed to madvise(MADV_WILLNEED) so the reads overlap, then touched.
+	 * Leaf pages are left alone, so after a restart every lookup faults
+	 * in at most its leaf instead of one page per level.
+	 * @param[in] txn A transaction handle returned by #mdb_txn_begin()
+	 * @param[in] dbi A database handle returned by #mdb_dbi_open()
+	 * @param[in] flags 0 or #MDB_WARMUP_LOCK to also mlock() the pages.
+	 * Locked pages stay resident until the environment is closed; the
+	 * process needs a large enough RLIMIT_MEMLOCK.
+	 * @param[out] pages If non-NULL, the number of branch pages visited.
+	 * @return A non-zero error value on failure and 0 on success. If only
+	 * mlock() failed all pages are still visited and its error is returned.
+	 */
+int mdb_dbi_warmup(MDB_txn *txn, MDB_dbi dbi, unsigned int flags, size_t *pages);
+
+	/** @brief Cut a database into key ranges of about equal size.
+	 *
+	 * Walks down from the root to the first level holding at least
+	 * \b parts nodes (or to the leaves) and returns the keys of evenly
+	 * spaced nodes of that level. Range i runs from keys[i-1] (or the
+	 * first key) up to but excluding keys[i] (or past the last key).
+	 * Pages below the cut level are not read.
+	 * @param[in] txn A transaction handle returned by #mdb_txn_begin()
+	 * @param[in] dbi A database handle returned by #mdb_dbi_open()
+	 * @param[in] parts The wanted number of ranges.
+	 * @param[out] keys Array of at least \b parts - 1 keys, ascending.
+	 * They point into the map and are valid like the data from #mdb_get().
+	 * @param[out] count The number of keys returned, less than \b parts - 1
+	 * if the database is too small.
+	 * @return A non-zero error value on failure and 0 on success.
+	 */
+int mdb_dbi_split(MDB_txn *txn, MDB_dbi dbi, unsigned int parts, MDB_val *keys, unsigned int *count);
+
 	/** @brief Close a database handle. Normally unnecessary. Use with care:
 	 *
 	 * This call is not mutex protected. Handles should only be closed by
@@ -1287,6 +1405,28 @@ int  mdb_set_relctx(MDB_txn *txn, MDB_dbi dbi, void *ctx);
 	 */
 int  mdb_get(MDB_txn *txn, MDB_dbi dbi, MDB_val *key, MDB_val *data);
 
+	/** @brief Get items for a batch of keys.
+	 *
+	 * Looks up \b n keys like #mdb_get(), but keeps several lookups in flight
+	 * and advances them one tree level at a time, prefetching each child page
+	 * before moving on to the next lookup. On trees larger than the CPU caches
+	 * the cache misses of the lookups overlap instead of adding up.
+	 * Databases with #MDB_DUPSORT fall back to one #mdb_get() per key.
+	 * @param[in] txn A transaction handle returned by #mdb_txn_begin()
+	 * @param[in] dbi A database handle returned by #mdb_dbi_open()
+	 * @param[in] keys An array of \b n keys
+	 * @param[out] data An array of \b n items, valid as for #mdb_get()
+	 * @param[out] rcs An array of \b n results, 0, #MDB_NOTFOUND or an error
+	 * @param[in] n The number of keys
+	 * @return A non-zero error value if the batch could not be started,
+	 * otherwise 0 and the result of each key is in \b rcs.
+	 * <ul>
+	 *	<li>EINVAL - an invalid parameter was specified.
+	 * </ul>
+	 */
+int  mdb_get_batch(MDB_txn *txn, MDB_dbi dbi, MDB_val *keys, MDB_val *data,
+	int *rcs, unsigned int n);
+
 	/** @brief Store items into a database.
 	 *
 	 * This function stores key/data pairs in the database. The default behavior
@@ -1544,6 +1684,42 @@ int  mdb_cursor_del(MDB_cursor *cursor, unsigned int flags);
 	 */
 int  mdb_cursor_count(MDB_cursor *cursor, size_t *countp);
 
+	/** @brief Read ahead towards the start of the database, see #mdb_cursor_readahead() */
+#define MDB_READAHEAD_PREV	0x01
+
+	/** @brief Advise the leaf pages a cursor scan is about to visit.
+	 *
+	 * Issues madvise(MADV_WILLNEED) for up to \b pages leaf pages after
+	 * (or with #MDB_READAHEAD_PREV, before) the cursor's current one.
+	 * The page numbers are taken from the parent branch page, so this
+	 * works however the leaves are laid out in the file, and also when
+	 * the environment was opened with #MDB_NORDAHEAD. The cursor remembers
+	 * what it advised: calling this after every step only issues new advice
+	 * once half of the window has been consumed. Readahead stops at the end
+	 * of the parent page and restarts from the next one. Overflow pages
+	 * are not included.
+	 * @param[in] cursor A cursor handle returned by #mdb_cursor_open()
+	 * @param[in] pages The number of leaf pages to keep advised ahead.
+	 * @param[in] flags 0 or #MDB_READAHEAD_PREV.
+	 * @return A non-zero error value on failure and 0 on success.
+	 */
+int  mdb_cursor_readahead(MDB_cursor *cursor, unsigned int pages, unsigned int flags);
+
+	/** @brief Return the first or last key of the cursor's leaf page.
+	 *
+	 * Lets a range scan check its bound once per page: when the last key
+	 * of the page (the first when scanning backwards) is inside the range,
+	 * so is every record the cursor reaches before leaving the page. The
+	 * key points at the same node memory as the keys #mdb_cursor_get()
+	 * returns, so comparing \b mv_data tells when the cursor reached it.
+	 * @param[in] cursor A cursor handle returned by #mdb_cursor_open()
+	 * @param[out] key The first or last key of the page.
+	 * @param[in] op #MDB_FIRST or #MDB_LAST.
+	 * @return A non-zero error value on failure and 0 on success. EINVAL
+	 * is returned if the cursor is not positioned.
+	 */
+int  mdb_cursor_leaf_key(MDB_cursor *cursor, MDB_val *key, MDB_cursor_op op);
+
 	/** @brief Compare two data items according to a particular database.
 	 *
 	 * This returns a comparison as if the two data items were keys in the
@@ -1592,6 +1768,31 @@ int	mdb_reader_list(MDB_env *env, MDB_msg_func *func, void *ctx);
 	 * @return 0 on success, non-zero on failure.
 	 */
 int	mdb_reader_check(MDB_env *env, int *dead);
+
+	/** @defgroup mdb_simd	Vector search levels
+	 *	@{
+	 */
+	/** scalar search, one comparator call per probe */
+#define MDB_SIMD_NONE	0
+	/** 128 bit compares */
+#define MDB_SIMD_SSE42	1
+	/** 256 bit compares */
+#define MDB_SIMD_AVX2	2
+	/** @} */
+
+	/** @brief Select the instruction set used to search packed fixed-size keys.
+	 *
+	 * Pages of #MDB_DUPFIXED duplicates store their items back to back.
+	 * When they are 4 or 8 bytes wide and compared by one of the built-in
+	 * integer or lexical comparators, the final steps of the binary search
+	 * compare several items per instruction. By default the best level
+	 * the CPU supports is used. The setting is process-wide and must be
+	 * made before any transaction is active in the process.
+	 * @param[in] level One of the @ref mdb_simd levels, or -1 for the default.
+	 * Levels the CPU does not support are lowered to the best one it does.
+	 * @return The level now in effect.
+	 */
+int	mdb_set_simd(int level);
 /**	@} */
 
 #ifdef __cplusplus
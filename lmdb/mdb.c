@@ -190,6 +190,47 @@ typedef SSIZE_T	ssize_t;
 #define MISALIGNED_OK	1
 #endif
 
+/** Search #P_LEAF2 pages of 4 or 8 byte keys with SSE4.2/AVX2.
+ *	The instruction set is picked at runtime, see #mdb_set_simd().
+ *	Compile with -DMDB_SIMD_SEARCH=0 to leave it out.
+ */
+#ifndef MDB_SIMD_SEARCH
+# if (defined(__i386) || defined(__x86_64)) && defined(__GNUC__)
+#  define MDB_SIMD_SEARCH	1
+# else
+#  define MDB_SIMD_SEARCH	0
+# endif
+#endif
+#if MDB_SIMD_SEARCH
+#include <immintrin.h>
+#endif
+
+/** Submit commit writes through io_uring, see #mdb_env_set_uring().
+ *	Set up with the raw syscalls, liburing is not needed.
+ *	Compile with -DMDB_USE_IO_URING=0 to leave it out.
+ */
+#ifndef MDB_USE_IO_URING
+# if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#   define MDB_USE_IO_URING	1
+#  endif
+# endif
+#endif
+#ifndef MDB_USE_IO_URING
+# define MDB_USE_IO_URING	0
+#endif
+#if MDB_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+/** Hint that a cache line is about to be read */
+#ifdef __GNUC__
+# define MDB_PREFETCH(p)	__builtin_prefetch((p), 0, 3)
+#else
+# define MDB_PREFETCH(p)	((void)0)
+#endif
+
 #include "lmdb.h"
 #include "midl.h"
 
@@ -1038,7 +1079,7 @@ typedef struct MDB_db {
 #define PERSISTENT_FLAGS	(0xffff & ~(MDB_VALID))
 	/** #mdb_dbi_open() flags */
 #define VALID_FLAGS	(MDB_REVERSEKEY|MDB_DUPSORT|MDB_INTEGERKEY|MDB_DUPFIXED|\
-	MDB_INTEGERDUP|MDB_REVERSEDUP|MDB_CREATE)
+	MDB_INTEGERDUP|MDB_REVERSEDUP|MDB_SHORTSEP|MDB_CREATE)
 
 	/** Handle for the DB used to track free pages. */
 #define	FREE_DBI	0
@@ -1087,6 +1128,10 @@ typedef union MDB_metabuf {
 	} mb_metabuf;
 } MDB_metabuf;
 
+	/** Binary search over the nodes of a page, see #mdb_node_search() */
+typedef unsigned (MDB_search_func)(MDB_page *mp, int low, int high,
+	MDB_val *key, MDB_cmp_func *cmp, MDB_node **nodep, int *rcp);
+
 	/** Auxiliary DB info.
 	 *	The information here is mostly static/read-only. There is
 	 *	only a single copy of this record in the environment.
@@ -1094,6 +1139,7 @@ typedef union MDB_metabuf {
 typedef struct MDB_dbx {
 	MDB_val		md_name;		/**< name of the database */
 	MDB_cmp_func	*md_cmp;	/**< function for comparing keys */
+	MDB_search_func	*md_search;	/**< node search with md_cmp inlined if it is a built-in */
 	MDB_cmp_func	*md_dcmp;	/**< function for comparing data items */
 	MDB_rel_func	*md_rel;	/**< user relocate function */
 	void		*md_relctx;		/**< user-provided context for md_rel */
@@ -1174,6 +1220,7 @@ struct MDB_txn {
 #define MDB_TXN_DIRTY		0x04		/**< must write, even if dirty list is empty */
 #define MDB_TXN_SPILLS		0x08		/**< txn or a parent has spilled pages */
 #define MDB_TXN_HAS_CHILD	0x10		/**< txn has an #MDB_txn.%mt_child */
+#define MDB_TXN_UNSORTED	0x20		/**< top-level dirty list is out of pgno order */
 	/** most operations on the txn are currently illegal */
 #define MDB_TXN_BLOCKED		(MDB_TXN_FINISHED|MDB_TXN_ERROR|MDB_TXN_HAS_CHILD)
 /** @} */
@@ -1184,6 +1231,14 @@ struct MDB_txn {
 	 *	dirty_list into mt_parent after freeing hidden mt_parent pages.
 	 */
 	unsigned int	mt_dirty_room;
+	/** @name Dirty list counters, see #mdb_txn_dirty_stat()
+	 *	@{
+	 */
+	unsigned int	mt_dirty_peak;	/**< most pages dirty_list held */
+	unsigned int	mt_spills;		/**< #mdb_page_spill() runs that wrote pages */
+	size_t			mt_spilled;		/**< pages written by those */
+	size_t			mt_unspilled;	/**< spilled pages dirtied again */
+/** @} */
 };
 
 /** Enough space for 2^32 nodes with minimum of 2 keys per node. I.e., plenty.
@@ -1233,6 +1288,9 @@ struct MDB_cursor {
 #define C_UNTRACK	0x40		/**< Un-track cursor when closing */
 /** @} */
 	unsigned int	mc_flags;	/**< @ref mdb_cursor */
+	pgno_t		mc_ra_pgno;	/**< parent page last used by #mdb_cursor_readahead() */
+	indx_t		mc_ra_lo;	/**< lowest child index of mc_ra_pgno advised */
+	indx_t		mc_ra_hi;	/**< highest child index of mc_ra_pgno advised */
 	MDB_page	*mc_pg[CURSOR_STACK];	/**< stack of pushed pages */
 	indx_t		mc_ki[CURSOR_STACK];	/**< stack of page indices */
 };
@@ -1276,6 +1334,32 @@ typedef struct MDB_pgstate {
 	txnid_t		mf_pglast;	/**< ID of last used record, or 0 if !mf_pghead */
 } MDB_pgstate;
 
+	/** A slot of the dirty list index, see #mdb_dirty_find() */
+typedef struct MDB_dxslot {
+	unsigned int	dx_gen;		/**< empty unless #MDB_env.%me_dirty_gen */
+	unsigned int	dx_idx;		/**< position in the dirty list */
+} MDB_dxslot;
+
+	/** Free runs of a node of the #MDB_pgruns tree, in pages */
+typedef struct MDB_runsum {
+	unsigned int	rs_pre;		/**< run at the start of the node */
+	unsigned int	rs_suf;		/**< run at the end of the node */
+	unsigned int	rs_max;		/**< longest run in the node */
+} MDB_runsum;
+
+	/** Bitmap of the pages in me_pghead, see #mdb_pgruns_find() */
+typedef struct MDB_pgruns {
+	pgno_t		*pr_mop;	/**< me_pghead it mirrors, NULL if stale */
+	MDB_ID		pr_len;		/**< its length */
+	unsigned int	pr_words;	/**< 64-page words, a power of 2 */
+	unsigned int	pr_nzlen;	/**< words in pr_nz, pr_words if it is full */
+	uint64_t	*pr_bits;	/**< bit set for a free page */
+	unsigned int	*pr_nz;		/**< words set since the last clear */
+	unsigned int	*pr_fix;	/**< scratch for #mdb_pgruns_fix() */
+	/** pr_tree[1] is the root, word w is leaf pr_tree[pr_words + w] */
+	MDB_runsum	*pr_tree;
+} MDB_pgruns;
+
 	/** The database environment. */
 struct MDB_env {
 	HANDLE		me_fd;		/**< The main data file */
@@ -1316,11 +1400,21 @@ struct MDB_env {
 	MDB_pgstate	me_pgstate;		/**< state of old pages from freeDB */
 #	define		me_pglast	me_pgstate.mf_pglast
 #	define		me_pghead	me_pgstate.mf_pghead
+	MDB_pgruns	me_pgruns;		/**< index of me_pghead for multi-page allocs */
 	MDB_page	*me_dpages;		/**< list of malloc'd blocks for re-use */
 	/** IDL of pages that became unused in a write txn */
 	MDB_IDL		me_free_pgs;
-	/** ID2L of pages written during a write txn. Length MDB_IDL_UM_SIZE. */
+	/** ID2L of pages written during a write txn. Room for me_dirty_cap IDs,
+	 *	grown up to me_dirty_max by #mdb_dirty_grow().
+	 */
 	MDB_ID2L	me_dirty_list;
+	unsigned int	me_dirty_cap;
+	/** Dirty pages a write txn may hold before it spills, see #mdb_env_set_dirty_max() */
+	unsigned int	me_dirty_max;
+	/** Hash index of a top-level txn's dirty list by pgno, at most half full */
+	MDB_dxslot	*me_dirty_ix;
+	unsigned int	me_dirty_ixmask;	/**< slots in me_dirty_ix, minus 1 */
+	unsigned int	me_dirty_gen;		/**< generation of the live slots */
 	/** Max number of freelist items that can fit in a single overflow page */
 	int			me_maxfree_1pg;
 	/** Max size of a node on a page */
@@ -1341,6 +1435,9 @@ struct MDB_env {
 #endif
 	void		*me_userctx;	 /**< User-settable context */
 	MDB_assert_func *me_assert_func; /**< Callback for assertion failures */
+#if MDB_USE_IO_URING
+	struct MDB_uring *me_uring;	/**< commit writes, see #mdb_env_set_uring() */
+#endif
 };
 
 	/** Nested transaction */
@@ -1444,6 +1541,9 @@ static int mdb_reader_check0(MDB_env *env, int rlocked, int *dead);
 
 /** @cond */
 static MDB_cmp_func	mdb_cmp_memn, mdb_cmp_memnr, mdb_cmp_int, mdb_cmp_cint, mdb_cmp_long;
+static MDB_search_func	mdb_search_memn, mdb_search_memnr, mdb_search_int, mdb_search_cint,
+	mdb_search_long, mdb_search_generic;
+static MDB_search_func *mdb_cmp_search(MDB_cmp_func *cmp);
 /** @endcond */
 
 /** Compare two items pointing at size_t's of unknown alignment. */
@@ -1851,6 +1951,152 @@ mdb_dpage_free(MDB_env *env, MDB_page *dp)
 	}
 }
 
+/** @defgroup dirtyix Dirty list index
+ * A top-level write txn appends to its dirty list and finds pages through
+ * an open addressing hash of their numbers, instead of a binary search and
+ * an insert that moves the tail. The list is sorted only when it must be
+ * walked in page order: to spill, to flush, and before a child txn starts.
+ * Child txns keep their small lists sorted as before.
+ * Bumping the generation empties the index without touching it.
+ *	@{
+ */
+#define MDB_DIRTY_HASH(pgno, mask) \
+	((unsigned int)(((uint64_t)(pgno) * 0x9E3779B97F4A7C15ULL) >> 32) & (mask))
+
+/** Allocate an empty dirty list index with room for \b cap pages.
+ * @param[in] env the environment.
+ * @param[in] cap the capacity of the dirty list.
+ * @return 0 on success, ENOMEM on failure.
+ */
+static int
+mdb_dirty_ixalloc(MDB_env *env, unsigned int cap)
+{
+	MDB_dxslot *ix;
+	size_t n = 2;
+
+	while (n < (size_t)cap * 2)
+		n <<= 1;
+	if (!(ix = calloc(n, sizeof(MDB_dxslot))))
+		return ENOMEM;
+	free(env->me_dirty_ix);
+	env->me_dirty_ix = ix;
+	env->me_dirty_ixmask = n - 1;
+	env->me_dirty_gen = 1;
+	return MDB_SUCCESS;
+}
+
+/** Add entry \b x of the top-level dirty list to the index. */
+static void
+mdb_dirty_ixadd(MDB_env *env, MDB_ID2L dl, unsigned int x)
+{
+	MDB_dxslot *ix = env->me_dirty_ix;
+	unsigned int mask = env->me_dirty_ixmask, gen = env->me_dirty_gen, h;
+
+	for (h = MDB_DIRTY_HASH(dl[x].mid, mask); ix[h].dx_gen == gen; h = (h+1) & mask)
+		;
+	ix[h].dx_gen = gen;
+	ix[h].dx_idx = x;
+}
+
+/** Index the whole dirty list of a top-level txn, after it was
+ * reordered or squashed.
+ */
+static void
+mdb_dirty_reindex(MDB_txn *txn)
+{
+	MDB_env *env = txn->mt_env;
+	MDB_ID2L dl = txn->mt_u.dirty_list;
+	unsigned int x;
+
+	if (!++env->me_dirty_gen) {
+		memset(env->me_dirty_ix, 0, ((size_t)env->me_dirty_ixmask + 1) * sizeof(MDB_dxslot));
+		env->me_dirty_gen = 1;
+	}
+	for (x = 1; x <= dl[0].mid; x++)
+		mdb_dirty_ixadd(env, dl, x);
+}
+
+/** Find a page in a txn's dirty list.
+ * @param[in] txn the transaction whose list to search.
+ * @param[in] pgno the page number.
+ * @return the position of the page in the list, or 0 if it is not there.
+ */
+static unsigned int
+mdb_dirty_find(MDB_txn *txn, pgno_t pgno)
+{
+	MDB_ID2L dl = txn->mt_u.dirty_list;
+	unsigned int x;
+
+	if (txn->mt_parent) {
+		x = mdb_mid2l_search(dl, pgno);
+		return (x <= dl[0].mid && dl[x].mid == pgno) ? x : 0;
+	} else {
+		MDB_env *env = txn->mt_env;
+		MDB_dxslot *ix = env->me_dirty_ix;
+		unsigned int mask = env->me_dirty_ixmask, gen = env->me_dirty_gen, h;
+
+		for (h = MDB_DIRTY_HASH(pgno, mask); ix[h].dx_gen == gen; h = (h+1) & mask) {
+			x = ix[h].dx_idx;
+			if (dl[x].mid == pgno)
+				return x;
+		}
+		return 0;
+	}
+}
+
+/** Remove entry \b x from the dirty list of a top-level txn.
+ * The last entry takes its place, the list may become unsorted.
+ */
+static void
+mdb_dirty_remove(MDB_txn *txn, unsigned int x)
+{
+	MDB_env *env = txn->mt_env;
+	MDB_ID2L dl = txn->mt_u.dirty_list;
+	MDB_dxslot *ix = env->me_dirty_ix;
+	unsigned int mask = env->me_dirty_ixmask, gen = env->me_dirty_gen;
+	unsigned int n = dl[0].mid, h, i, k;
+
+	for (h = MDB_DIRTY_HASH(dl[x].mid, mask); ix[h].dx_gen != gen || ix[h].dx_idx != x;
+		h = (h+1) & mask)
+		;
+	/* Empty the slot, then pull back later slots of the probe run
+	 * which would no longer be reachable from their home slot.
+	 */
+	for (i = h;;) {
+		ix[i].dx_gen = 0;
+		do {
+			h = (h+1) & mask;
+			if (ix[h].dx_gen != gen)
+				goto emptied;
+			k = MDB_DIRTY_HASH(dl[ix[h].dx_idx].mid, mask);
+		} while (i <= h ? (i < k && k <= h) : (i < k || k <= h));
+		ix[i] = ix[h];
+		i = h;
+	}
+emptied:
+	if (x != n) {
+		for (h = MDB_DIRTY_HASH(dl[n].mid, mask); ix[h].dx_gen != gen || ix[h].dx_idx != n;
+			h = (h+1) & mask)
+			;
+		ix[h].dx_idx = x;
+		dl[x] = dl[n];
+		txn->mt_flags |= MDB_TXN_UNSORTED;
+	}
+	dl[0].mid = n - 1;
+}
+
+/** Sort the dirty list of a top-level txn by page number, if it isn't. */
+static void
+mdb_dirty_sort(MDB_txn *txn)
+{
+	if (txn->mt_flags & MDB_TXN_UNSORTED) {
+		mdb_mid2l_sort(txn->mt_u.dirty_list);
+		mdb_dirty_reindex(txn);
+		txn->mt_flags ^= MDB_TXN_UNSORTED;
+	}
+}
+/** @} */
+
 /**	Return all dirty pages to dpage list */
 static void
 mdb_dlist_free(MDB_txn *txn)
@@ -1987,7 +2233,7 @@ mdb_pages_xkeep(MDB_cursor *mc, unsigned pflags, int all)
 	return rc;
 }
 
-static int mdb_page_flush(MDB_txn *txn, int keep);
+static int mdb_page_flush(MDB_txn *txn, int keep, int *synced);
 
 /**	Spill pages from the dirty list back to disk.
  * This is intended to prevent running into #MDB_TXN_FULL situations,
@@ -2027,7 +2273,7 @@ mdb_page_spill(MDB_cursor *m0, MDB_val *key, MDB_val *data)
 	MDB_txn *txn = m0->mc_txn;
 	MDB_page *dp;
 	MDB_ID2L dl = txn->mt_u.dirty_list;
-	unsigned int i, j, need;
+	unsigned int i, j, need, spilled;
 	int rc;
 
 	if (m0->mc_flags & C_SUB)
@@ -2047,6 +2293,9 @@ mdb_page_spill(MDB_cursor *m0, MDB_val *key, MDB_val *data)
 	if (txn->mt_dirty_room > i)
 		return MDB_SUCCESS;
 
+	/* Spill from the tail of the list, the highest page numbers */
+	mdb_dirty_sort(txn);
+
 	if (!txn->mt_spill_pgs) {
 		txn->mt_spill_pgs = mdb_midl_alloc(MDB_IDL_UM_MAX);
 		if (!txn->mt_spill_pgs)
@@ -2074,8 +2323,9 @@ mdb_page_spill(MDB_cursor *m0, MDB_val *key, MDB_val *data)
 	 * of the dirty pages. Testing revealed this to be a good tradeoff,
 	 * better than 1/2, 1/4, or 1/10.
 	 */
-	if (need < MDB_IDL_UM_MAX / 8)
-		need = MDB_IDL_UM_MAX / 8;
+	if (need < txn->mt_env->me_dirty_max / 8)
+		need = txn->mt_env->me_dirty_max / 8;
+	spilled = need;
 
 	/* Save the page IDs of all the pages we're flushing */
 	/* flush from the tail forward, this saves a lot of shifting later on. */
@@ -2108,11 +2358,13 @@ mdb_page_spill(MDB_cursor *m0, MDB_val *key, MDB_val *data)
 	mdb_midl_sort(txn->mt_spill_pgs);
 
 	/* Flush the spilled part of dirty list */
-	if ((rc = mdb_page_flush(txn, i)) != MDB_SUCCESS)
+	if ((rc = mdb_page_flush(txn, i, NULL)) != MDB_SUCCESS)
 		goto done;
 
 	/* Reset any dirty pages we kept that page_flush didn't see */
 	rc = mdb_pages_xkeep(m0, P_DIRTY|P_KEEP, i);
+	txn->mt_spills++;
+	txn->mt_spilled += spilled - need;
 
 done:
 	txn->mt_flags |= rc ? MDB_TXN_ERROR : MDB_TXN_SPILLS;
@@ -2143,20 +2395,353 @@ static void
 mdb_page_dirty(MDB_txn *txn, MDB_page *mp)
 {
 	MDB_ID2 mid;
-	int rc, (*insert)(MDB_ID2L, MDB_ID2 *);
+	MDB_ID2L dl = txn->mt_u.dirty_list;
+	unsigned int x;
+	int rc;
 
-	if (txn->mt_flags & MDB_TXN_WRITEMAP) {
-		insert = mdb_mid2l_append;
-	} else {
-		insert = mdb_mid2l_insert;
-	}
 	mid.mid = mp->mp_pgno;
 	mid.mptr = mp;
-	rc = insert(txn->mt_u.dirty_list, &mid);
-	mdb_tassert(txn, rc == 0);
+	if (txn->mt_parent) {
+		rc = mdb_mid2l_insert(dl, &mid);
+		mdb_tassert(txn, rc == 0);
+	} else {
+		x = dl[0].mid;
+		mdb_tassert(txn, x < txn->mt_env->me_dirty_cap);
+		if (x && dl[x].mid > mid.mid)
+			txn->mt_flags |= MDB_TXN_UNSORTED;
+		dl[++x] = mid;
+		dl[0].mid = x;
+		mdb_dirty_ixadd(txn->mt_env, dl, x);
+	}
 	txn->mt_dirty_room--;
+	if (txn->mt_u.dirty_list[0].mid > txn->mt_dirty_peak)
+		txn->mt_dirty_peak = txn->mt_u.dirty_list[0].mid;
 }
 
+/** Make room in a top-level txn's dirty list for one more page.
+ * The list starts at the default size and doubles as needed, up to
+ * #MDB_env.%me_dirty_max. The env keeps it for the next write txns.
+ * @param[in] txn the transaction about to dirty a page.
+ * @return 0 on success, ENOMEM on failure.
+ */
+static int
+mdb_dirty_grow(MDB_txn *txn)
+{
+	MDB_env *env = txn->mt_env;
+	MDB_ID2L dl;
+	unsigned int cap;
+
+	if (txn->mt_parent || txn->mt_u.dirty_list[0].mid < env->me_dirty_cap)
+		return MDB_SUCCESS;
+	cap = env->me_dirty_cap * 2 > env->me_dirty_max ? env->me_dirty_max : env->me_dirty_cap * 2;
+	if (cap <= env->me_dirty_cap)
+		return MDB_TXN_FULL;
+	dl = realloc(env->me_dirty_list, ((size_t)cap + 1) * sizeof(MDB_ID2));
+	if (!dl)
+		return ENOMEM;
+	env->me_dirty_list = txn->mt_u.dirty_list = dl;
+	if (mdb_dirty_ixalloc(env, cap))
+		return ENOMEM;
+	env->me_dirty_cap = cap;
+	mdb_dirty_reindex(txn);
+	return MDB_SUCCESS;
+}
+
+/** @defgroup pgruns Free page runs
+ * #mdb_page_alloc() needs \b num consecutive pages for an overflow value.
+ * It scans me_pghead for them, and after every freeDB record it merges
+ * it scans again. Once a scan of a large me_pghead failed, me_pghead is
+ * mirrored as a bitmap of free pages with a tree over the bitmap words.
+ * Each tree node has the free runs at its start and end and the longest
+ * one inside, so the lowest run of at least \b num pages is found in
+ * O(log pages). That is the run the scan from the tail of me_pghead would
+ * find. Merged records, allocations and freed overflow pages update the
+ * bitmap and the tree above the words they touch.
+ *
+ * me_pghead starts empty in each write txn. The bitmap is emptied by
+ * clearing the words that were set, not the whole of it. When me_pghead
+ * changed behind its back, in #mdb_freelist_save() or a child txn, it is
+ * rebuilt on next use. A run found is checked against me_pghead before it
+ * is used.
+ *
+ * The index is only an accelerator: when it can not be allocated the
+ * scan is used. It takes about 40 bytes per 64 pages below mt_next_pgno,
+ * rounded up to a power of 2, e.g. 2.5MB for a 16GB map of 4KB pages.
+ * Up to #MDB_PGRUNS_KEEP words it is kept for the next write txn, a
+ * larger one is freed when the write txn ends.
+ *	@{
+ */
+
+	/** Smallest me_pghead worth a bitmap once a scan of it failed */
+#define MDB_PGRUNS_MIN	1024
+
+	/** Largest bitmap in words kept between write txns */
+#define MDB_PGRUNS_KEEP	65536
+
+/** Free the bitmap of \b pr. */
+static void
+mdb_pgruns_free(MDB_pgruns *pr)
+{
+	free(pr->pr_bits);
+	free(pr->pr_tree);
+	free(pr->pr_nz);
+	pr->pr_mop = NULL;
+	pr->pr_bits = NULL;
+	pr->pr_tree = NULL;
+	pr->pr_nz = NULL;
+	pr->pr_fix = NULL;
+	pr->pr_words = 0;
+	pr->pr_nzlen = 0;
+}
+
+/** Update the tree above some bitmap words.
+ * @param[in] pr the bitmap.
+ * @param[in,out] ks the leaves of the words, in ascending or descending
+ * order. Used as scratch space.
+ * @param[in] n the number of leaves.
+ */
+static void
+mdb_pgruns_fix(MDB_pgruns *pr, unsigned int *ks, unsigned int n)
+{
+	MDB_runsum *t = pr->pr_tree, *l, *r;
+	unsigned int i, j, k, span, m;
+	uint64_t x, y;
+
+	/* Bits set are free pages, bit 0 is the lowest page */
+	for (i = 0; i < n; i++) {
+		k = ks[i];
+		x = pr->pr_bits[k - pr->pr_words];
+		for (m = 0, y = x; y; m++)
+			y &= y >> 1;
+		t[k].rs_pre = x == ~(uint64_t)0 ? 64 : __builtin_ctzll(~x);
+		t[k].rs_suf = x == ~(uint64_t)0 ? 64 : __builtin_clzll(~x);
+		t[k].rs_max = m;
+	}
+	/* Each level up, once per parent */
+	for (span = 64; n && ks[0] > 1; span <<= 1) {
+		for (i = j = 0; i < n; i++) {
+			k = ks[i] >> 1;
+			if (j && ks[j-1] == k)
+				continue;
+			ks[j++] = k;
+			l = &t[2*k];
+			r = &t[2*k+1];
+			t[k].rs_pre = l->rs_pre == span ? span + r->rs_pre : l->rs_pre;
+			t[k].rs_suf = r->rs_suf == span ? span + l->rs_suf : r->rs_suf;
+			m = l->rs_suf + r->rs_pre;
+			if (m < l->rs_max) m = l->rs_max;
+			if (m < r->rs_max) m = r->rs_max;
+			t[k].rs_max = m;
+		}
+		n = j;
+	}
+}
+
+/** Add the pages of an IDL to the bitmap.
+ * @return 0 on success, -1 if some are past its end.
+ */
+static int
+mdb_pgruns_addlist(MDB_pgruns *pr, MDB_IDL ids)
+{
+	unsigned int i, w, n = 0, *ks = pr->pr_fix;
+
+	/* ids is sorted descending, the highest page is first */
+	if (ids[0] && ids[1] >= (pgno_t)pr->pr_words * 64)
+		return -1;
+	for (i = 1; i <= ids[0]; i++) {
+		w = ids[i] >> 6;
+		if (!pr->pr_bits[w] && pr->pr_nzlen < pr->pr_words)
+			pr->pr_nz[pr->pr_nzlen++] = w;
+		pr->pr_bits[w] |= (uint64_t)1 << (ids[i] & 63);
+		if (!n || ks[n-1] != pr->pr_words + w)
+			ks[n++] = pr->pr_words + w;
+	}
+	mdb_pgruns_fix(pr, ks, n);
+	return 0;
+}
+
+/** Mark \b num pages from \b pgno free or used in the bitmap.
+ * @return 0 on success, -1 if they are past its end.
+ */
+static int
+mdb_pgruns_set(MDB_pgruns *pr, pgno_t pgno, unsigned int num, int isfree)
+{
+	pgno_t end = pgno + num;
+	unsigned int w, n = 0, *ks = pr->pr_fix;
+	uint64_t mask;
+
+	if (end > (pgno_t)pr->pr_words * 64)
+		return -1;
+	for (; pgno < end; pgno = (pgno | 63) + 1) {
+		w = pgno >> 6;
+		mask = ~(uint64_t)0 << (pgno & 63);
+		if (end - (pgno & ~(pgno_t)63) < 64)
+			mask &= ~(~(uint64_t)0 << (end & 63));
+		if (isfree) {
+			if (!pr->pr_bits[w] && pr->pr_nzlen < pr->pr_words)
+				pr->pr_nz[pr->pr_nzlen++] = w;
+			pr->pr_bits[w] |= mask;
+		} else {
+			pr->pr_bits[w] &= ~mask;
+		}
+		ks[n++] = pr->pr_words + w;
+	}
+	mdb_pgruns_fix(pr, ks, n);
+	return 0;
+}
+
+/** Build the bitmap of me_pghead, big enough for the pages of \b txn.
+ * @return 0 on success, ENOMEM on failure.
+ */
+static int
+mdb_pgruns_build(MDB_txn *txn)
+{
+	MDB_env *env = txn->mt_env;
+	MDB_pgruns *pr = &env->me_pgruns;
+	pgno_t *mop = env->me_pghead, top = txn->mt_next_pgno;
+	unsigned int i, k, words;
+
+	pr->pr_mop = NULL;
+	if (mop[0] && mop[1] >= top)
+		top = mop[1] + 1;
+	for (words = 1; (pgno_t)words * 64 < top; words <<= 1)
+		;
+	if (words > pr->pr_words) {
+		/* A larger tree has another shape, start from scratch */
+		mdb_pgruns_free(pr);
+		pr->pr_bits = calloc(words, sizeof(uint64_t));
+		pr->pr_tree = calloc(2 * words, sizeof(MDB_runsum));
+		pr->pr_nz = malloc(2 * words * sizeof(unsigned int));
+		if (!pr->pr_bits || !pr->pr_tree || !pr->pr_nz) {
+			mdb_pgruns_free(pr);
+			return ENOMEM;
+		}
+		pr->pr_fix = pr->pr_nz + words;
+		pr->pr_words = words;
+	} else if (pr->pr_nzlen < pr->pr_words) {
+		/* All clear is all used, which is tree nodes of zero */
+		for (i = 0; i < pr->pr_nzlen; i++) {
+			pr->pr_bits[pr->pr_nz[i]] = 0;
+			for (k = pr->pr_words + pr->pr_nz[i]; k; k >>= 1)
+				memset(&pr->pr_tree[k], 0, sizeof(MDB_runsum));
+		}
+	} else {
+		memset(pr->pr_bits, 0, pr->pr_words * sizeof(uint64_t));
+		memset(pr->pr_tree, 0, 2 * pr->pr_words * sizeof(MDB_runsum));
+	}
+	pr->pr_nzlen = 0;
+	mdb_pgruns_addlist(pr, mop);
+	pr->pr_mop = mop;
+	pr->pr_len = mop[0];
+	return MDB_SUCCESS;
+}
+
+/** Find the lowest run of at least \b num pages in me_pghead by scanning
+ * it from the tail.
+ * @return the position in me_pghead of the first page of the run, or 0.
+ */
+static unsigned int
+mdb_pgruns_scan(pgno_t *mop, unsigned int num)
+{
+	unsigned int i = mop[0], n2 = num-1;
+
+	do {
+		if (mop[i-n2] == mop[i]+n2)
+			return i;
+	} while (--i > n2);
+	return 0;
+}
+
+/** Find the lowest run of at least \b num pages in me_pghead.
+ * @param[in] txn the write transaction.
+ * @param[in] num the number of pages needed, more than 1 and no more
+ * than the length of me_pghead.
+ * @return the position in me_pghead of the first page of the run, or 0
+ * if there is no such run.
+ */
+static unsigned int
+mdb_pgruns_find(MDB_txn *txn, unsigned int num)
+{
+	MDB_env *env = txn->mt_env;
+	MDB_pgruns *pr = &env->me_pgruns;
+	pgno_t *mop = env->me_pghead, pgno;
+	unsigned int k, i, span, n2 = num-1;
+	MDB_runsum *t;
+	uint64_t x, y;
+	int tries;
+
+	for (tries = 0; tries < 2; tries++) {
+		if (pr->pr_mop != mop || pr->pr_len != mop[0]) {
+			if (!tries) {
+				/* Scan as before, the bitmap pays off once it fails */
+				if ((i = mdb_pgruns_scan(mop, num)) || mop[0] < MDB_PGRUNS_MIN)
+					return i;
+				if (mdb_pgruns_build(txn))
+					return 0;
+			} else if (mdb_pgruns_build(txn)) {
+				return mdb_pgruns_scan(mop, num);
+			}
+		}
+		t = pr->pr_tree;
+		if (t[1].rs_max < num)
+			break;
+		pgno = 0;
+		for (k = 1, span = pr->pr_words * 64; k < pr->pr_words; span >>= 1) {
+			if (t[2*k].rs_max >= num) {
+				k = 2*k;
+			} else if (t[2*k].rs_suf + t[2*k+1].rs_pre >= num) {
+				/* the run crosses the middle of this node */
+				pgno += span/2 - t[2*k].rs_suf;
+				break;
+			} else {
+				k = 2*k+1;
+				pgno += span/2;
+			}
+		}
+		if (k >= pr->pr_words) {
+			/* the run is inside one word */
+			x = y = pr->pr_bits[k - pr->pr_words];
+			for (i = 1; i < num; i++)
+				y &= x >> i;
+			pgno += __builtin_ctzll(y);
+		}
+		i = mdb_midl_search(mop, pgno);
+		if (i <= mop[0] && mop[i] == pgno && i > n2 && mop[i-n2] == pgno+n2)
+			return i;
+		/* me_pghead was changed in place, start over */
+		pr->pr_mop = NULL;
+	}
+	return 0;
+}
+
+/** Record that pages were added to or taken from me_pghead.
+ * @param[in] env the environment.
+ * @param[in] mop me_pghead before the change, it may have been reallocated.
+ * @param[in] len its length before the change.
+ * @param[in] ids an IDL of pages added, or NULL.
+ * @param[in] pgno the first of \b num consecutive pages added or taken,
+ * when \b ids is NULL.
+ * @param[in] isfree whether the pages were added.
+ */
+static void
+mdb_pgruns_note(MDB_env *env, pgno_t *mop, MDB_ID len, MDB_IDL ids,
+	pgno_t pgno, unsigned int num, int isfree)
+{
+	MDB_pgruns *pr = &env->me_pgruns;
+
+	if (!mop || pr->pr_mop != mop || pr->pr_len != len)
+		goto stale;
+	if (ids ? mdb_pgruns_addlist(pr, ids) :
+		mdb_pgruns_set(pr, pgno, num, isfree))
+		goto stale;
+	pr->pr_mop = env->me_pghead;
+	pr->pr_len = env->me_pghead[0];
+	return;
+stale:
+	pr->pr_mop = NULL;
+}
+/** @} */
+
 /** Allocate page numbers and memory for writing.  Maintain me_pglast,
  * me_pghead and mt_next_pgno.  Set #MDB_TXN_ERROR on failure.
  *
@@ -2189,7 +2774,7 @@ mdb_page_alloc(MDB_cursor *mc, int num, MDB_page **mp)
 	int rc, retry = num * 60;
 	MDB_txn *txn = mc->mc_txn;
 	MDB_env *env = txn->mt_env;
-	pgno_t pgno, *mop = env->me_pghead;
+	pgno_t pgno, *mop = env->me_pghead, *mop0;
 	unsigned i, j, mop_len = mop ? mop[0] : 0, n2 = num-1;
 	MDB_page *np;
 	txnid_t oldest = 0, last;
@@ -2215,6 +2800,8 @@ mdb_page_alloc(MDB_cursor *mc, int num, MDB_page **mp)
 		rc = MDB_TXN_FULL;
 		goto fail;
 	}
+	if ((rc = mdb_dirty_grow(txn)))
+		goto fail;
 
 	for (op = MDB_FIRST;; op = MDB_NEXT) {
 		MDB_val key, data;
@@ -2225,12 +2812,14 @@ mdb_page_alloc(MDB_cursor *mc, int num, MDB_page **mp)
 		 * pages at the tail, just truncating the list.
 		 */
 		if (mop_len > n2) {
-			i = mop_len;
-			do {
+			if (!n2) {
+				pgno = mop[i = mop_len];
+				goto search_done;
+			}
+			if ((i = mdb_pgruns_find(txn, num))) {
 				pgno = mop[i];
-				if (mop[i-n2] == pgno+n2)
-					goto search_done;
-			} while (--i > n2);
+				goto search_done;
+			}
 			if (--retry < 0)
 				break;
 		}
@@ -2285,6 +2874,7 @@ mdb_page_alloc(MDB_cursor *mc, int num, MDB_page **mp)
 
 		idl = (MDB_ID *) data.mv_data;
 		i = idl[0];
+		mop0 = mop;
 		if (!mop) {
 			if (!(env->me_pghead = mop = mdb_midl_alloc(i))) {
 				rc = ENOMEM;
@@ -2304,6 +2894,7 @@ mdb_page_alloc(MDB_cursor *mc, int num, MDB_page **mp)
 #endif
 		/* Merge in descending sorted order */
 		mdb_midl_xmerge(mop, idl);
+		mdb_pgruns_note(env, mop0, mop_len, idl, 0, 0, 1);
 		mop_len = mop[0];
 	}
 
@@ -2330,6 +2921,7 @@ search_done:
 		/* Move any stragglers down */
 		for (j = i-num; j < mop_len; )
 			mop[++j] = mop[++i];
+		mdb_pgruns_note(env, mop, mop_len + num, NULL, pgno, num, 0);
 	} else {
 		txn->mt_next_pgno = pgno + num;
 	}
@@ -2390,9 +2982,11 @@ mdb_page_unspill(MDB_txn *txn, MDB_page *mp, MDB_page **ret)
 		x = mdb_midl_search(tx2->mt_spill_pgs, pn);
 		if (x <= tx2->mt_spill_pgs[0] && tx2->mt_spill_pgs[x] == pn) {
 			MDB_page *np;
-			int num;
+			int num, rc;
 			if (txn->mt_dirty_room == 0)
 				return MDB_TXN_FULL;
+			if ((rc = mdb_dirty_grow(txn)))
+				return rc;
 			if (IS_OVERFLOW(mp))
 				num = mp->mp_pages;
 			else
@@ -2423,6 +3017,7 @@ mdb_page_unspill(MDB_txn *txn, MDB_page *mp, MDB_page **ret)
 
 			mdb_page_dirty(txn, np);
 			np->mp_flags |= P_DIRTY;
+			txn->mt_unspilled++;
 			*ret = np;
 			break;
 		}
@@ -2791,9 +3386,13 @@ mdb_txn_renew0(MDB_txn *txn)
 		txn->mt_child = NULL;
 		txn->mt_loose_pgs = NULL;
 		txn->mt_loose_count = 0;
-		txn->mt_dirty_room = MDB_IDL_UM_MAX;
+		txn->mt_dirty_room = env->me_dirty_max;
+		txn->mt_dirty_peak = 0;
+		txn->mt_spills = 0;
+		txn->mt_spilled = txn->mt_unspilled = 0;
 		txn->mt_u.dirty_list = env->me_dirty_list;
 		txn->mt_u.dirty_list[0].mid = 0;
+		mdb_dirty_reindex(txn);
 		txn->mt_free_pgs = env->me_free_pgs;
 		txn->mt_free_pgs[0] = 0;
 		txn->mt_spill_pgs = NULL;
@@ -2867,6 +3466,14 @@ mdb_txn_begin(MDB_env *env, MDB_txn *parent, unsigned int flags, MDB_txn **ret)
 		if (flags & (MDB_RDONLY|MDB_WRITEMAP|MDB_TXN_BLOCKED)) {
 			return (parent->mt_flags & MDB_TXN_RDONLY) ? EINVAL : MDB_BAD_TXN;
 		}
+		/* A child's dirty list has the default size, it could not
+		 * merge a parent's larger one on commit.
+		 */
+		if (env->me_dirty_max > MDB_IDL_UM_MAX)
+			return MDB_INCOMPATIBLE;
+		/* The child merges its sorted list into ours on commit */
+		mdb_dirty_sort(parent);
+		flags &= ~MDB_TXN_UNSORTED;
 		/* Child txns save MDB_pgstate and use own copy of cursors */
 		size = env->me_maxdbs * (sizeof(MDB_db)+sizeof(MDB_cursor *)+1);
 		size += tsize = sizeof(MDB_ntxn);
@@ -2904,6 +3511,9 @@ mdb_txn_begin(MDB_env *env, MDB_txn *parent, unsigned int flags, MDB_txn **ret)
 		}
 		txn->mt_txnid = parent->mt_txnid;
 		txn->mt_dirty_room = parent->mt_dirty_room;
+		txn->mt_dirty_peak = 0;
+		txn->mt_spills = 0;
+		txn->mt_spilled = txn->mt_unspilled = 0;
 		txn->mt_u.dirty_list[0].mid = 0;
 		txn->mt_spill_pgs = NULL;
 		txn->mt_next_pgno = parent->mt_next_pgno;
@@ -3044,6 +3654,8 @@ mdb_txn_end(MDB_txn *txn, unsigned mode)
 			/* me_pgstate: */
 			env->me_pghead = NULL;
 			env->me_pglast = 0;
+			if (env->me_pgruns.pr_words > MDB_PGRUNS_KEEP)
+				mdb_pgruns_free(&env->me_pgruns);
 
 			env->me_txn = NULL;
 			mode = 0;	/* txn == env->me_txn0, do not free() it */
@@ -3130,16 +3742,10 @@ mdb_freelist_save(MDB_txn *txn)
 		for (; mp; mp = NEXT_LOOSE_PAGE(mp)) {
 			mdb_midl_xappend(txn->mt_free_pgs, mp->mp_pgno);
 			/* must also remove from dirty list */
-			if (txn->mt_flags & MDB_TXN_WRITEMAP) {
-				for (x=1; x<=dl[0].mid; x++)
-					if (dl[x].mid == mp->mp_pgno)
-						break;
-				mdb_tassert(txn, x <= dl[0].mid);
-			} else {
-				x = mdb_mid2l_search(dl, mp->mp_pgno);
-				mdb_tassert(txn, dl[x].mid == mp->mp_pgno);
+			x = mdb_dirty_find(txn, mp->mp_pgno);
+			mdb_tassert(txn, x != 0);
+			if (!(txn->mt_flags & MDB_TXN_WRITEMAP))
 				mdb_dpage_free(env, mp);
-			}
 			dl[x].mptr = NULL;
 		}
 		{
@@ -3157,6 +3763,7 @@ mdb_freelist_save(MDB_txn *txn)
 				/* all slots freed */
 				dl[0].mid = 0;
 			}
+			mdb_dirty_reindex(txn);
 		}
 		txn->mt_loose_pgs = NULL;
 		txn->mt_loose_count = 0;
@@ -3315,13 +3922,341 @@ mdb_freelist_save(MDB_txn *txn)
 	return rc;
 }
 
+#if MDB_USE_IO_URING
+	/** user_data of the data sync entry, slots are numbered from 0 */
+#define MDB_URING_SYNC	(~(__u64)0)
+
+	/** One write in flight: a run of pages like a single pwritev() call */
+typedef struct MDB_uring_slot {
+	off_t		us_pos;
+	size_t		us_size;
+	int			us_n;
+} MDB_uring_slot;
+
+	/** An io_uring for #mdb_page_flush(). Only the committing writer uses it.
+	 *	Every slot owns #MDB_COMMIT_PAGES iovecs, the SQ has room for one
+	 *	more entry than there are slots, for the data sync.
+	 */
+typedef struct MDB_uring {
+	int			ur_fd;
+	unsigned	ur_depth;		/**< number of slots */
+	unsigned	ur_nfree;		/**< entries in ur_free */
+	unsigned	ur_queued;		/**< entries not yet submitted */
+	unsigned	ur_busy;		/**< entries submitted or queued, not completed */
+	int			ur_resync;		/**< a short write was finished with pwrite() */
+	int			ur_broken;		/**< io_uring_enter() failed, see #mdb_uring_drop() */
+	unsigned	*ur_sqhead, *ur_sqtail, *ur_sqmask, *ur_sqarray;
+	unsigned	*ur_cqhead, *ur_cqtail, *ur_cqmask;
+	struct io_uring_sqe *ur_sqes;
+	struct io_uring_cqe *ur_cqes;
+	void		*ur_sqmap, *ur_cqmap;
+	size_t		ur_sqlen, ur_cqlen, ur_sqeslen;
+	unsigned	*ur_free;		/**< free slot numbers */
+	MDB_uring_slot *ur_slots;
+	struct iovec *ur_iov;
+} MDB_uring;
+
+static void
+mdb_uring_free(MDB_uring *ur)
+{
+	if (!ur)
+		return;
+	if (ur->ur_sqes)
+		munmap(ur->ur_sqes, ur->ur_sqeslen);
+	if (ur->ur_cqmap && ur->ur_cqmap != ur->ur_sqmap)
+		munmap(ur->ur_cqmap, ur->ur_cqlen);
+	if (ur->ur_sqmap)
+		munmap(ur->ur_sqmap, ur->ur_sqlen);
+	if (ur->ur_fd >= 0)
+		close(ur->ur_fd);
+	free(ur->ur_free);
+	free(ur->ur_slots);
+	free(ur->ur_iov);
+	free(ur);
+}
+
+static int
+mdb_uring_create(unsigned depth, MDB_uring **ret)
+{
+	struct io_uring_params p;
+	MDB_uring *ur;
+	char *sq, *cq;
+	unsigned i;
+	int rc;
+
+	if (!(ur = calloc(1, sizeof(MDB_uring))))
+		return ENOMEM;
+	ur->ur_fd = -1;
+	memset(&p, 0, sizeof(p));
+	ur->ur_fd = syscall(__NR_io_uring_setup, depth + 1, &p);
+	if (ur->ur_fd < 0) {
+		rc = ErrCode();
+		goto fail;
+	}
+	ur->ur_sqlen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ur->ur_cqlen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ur->ur_cqlen > ur->ur_sqlen)
+			ur->ur_sqlen = ur->ur_cqlen;
+		ur->ur_cqlen = ur->ur_sqlen;
+	}
+	sq = mmap(NULL, ur->ur_sqlen, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+		ur->ur_fd, IORING_OFF_SQ_RING);
+	if (sq == MAP_FAILED) {
+		rc = ErrCode();
+		goto fail;
+	}
+	ur->ur_sqmap = sq;
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		cq = sq;
+	} else {
+		cq = mmap(NULL, ur->ur_cqlen, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			ur->ur_fd, IORING_OFF_CQ_RING);
+		if (cq == MAP_FAILED) {
+			rc = ErrCode();
+			goto fail;
+		}
+	}
+	ur->ur_cqmap = cq;
+	ur->ur_sqeslen = p.sq_entries * sizeof(struct io_uring_sqe);
+	ur->ur_sqes = mmap(NULL, ur->ur_sqeslen, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+		ur->ur_fd, IORING_OFF_SQES);
+	if (ur->ur_sqes == MAP_FAILED) {
+		ur->ur_sqes = NULL;
+		rc = ErrCode();
+		goto fail;
+	}
+	ur->ur_sqhead = (unsigned *)(sq + p.sq_off.head);
+	ur->ur_sqtail = (unsigned *)(sq + p.sq_off.tail);
+	ur->ur_sqmask = (unsigned *)(sq + p.sq_off.ring_mask);
+	ur->ur_sqarray = (unsigned *)(sq + p.sq_off.array);
+	ur->ur_cqhead = (unsigned *)(cq + p.cq_off.head);
+	ur->ur_cqtail = (unsigned *)(cq + p.cq_off.tail);
+	ur->ur_cqmask = (unsigned *)(cq + p.cq_off.ring_mask);
+	ur->ur_cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	ur->ur_depth = depth;
+	ur->ur_free = malloc(depth * sizeof(unsigned));
+	ur->ur_slots = malloc(depth * sizeof(MDB_uring_slot));
+	ur->ur_iov = malloc((size_t)depth * MDB_COMMIT_PAGES * sizeof(struct iovec));
+	if (!ur->ur_free || !ur->ur_slots || !ur->ur_iov) {
+		rc = ENOMEM;
+		goto fail;
+	}
+	for (i = 0; i < depth; i++)
+		ur->ur_free[i] = depth - 1 - i;
+	ur->ur_nfree = depth;
+	*ret = ur;
+	return MDB_SUCCESS;
+
+fail:
+	mdb_uring_free(ur);
+	return rc;
+}
+
+static struct io_uring_sqe *
+mdb_uring_sqe(MDB_uring *ur)
+{
+	unsigned tail = *ur->ur_sqtail, idx = tail & *ur->ur_sqmask;
+	struct io_uring_sqe *sqe = &ur->ur_sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	ur->ur_sqarray[idx] = idx;
+	__atomic_store_n(ur->ur_sqtail, tail + 1, __ATOMIC_RELEASE);
+	ur->ur_queued++;
+	ur->ur_busy++;
+	return sqe;
+}
+
+	/** Write what a short (or interrupted) ring write left, synchronously */
+static int
+mdb_uring_rest(HANDLE fd, struct iovec *iov, int n, off_t pos, size_t done)
+{
+	ssize_t wres;
+	size_t len;
+	char *ptr;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (done >= iov[i].iov_len) {
+			done -= iov[i].iov_len;
+			pos += iov[i].iov_len;
+			continue;
+		}
+		ptr = (char *)iov[i].iov_base + done;
+		len = iov[i].iov_len - done;
+		pos += done;
+		done = 0;
+		while (len) {
+			wres = pwrite(fd, ptr, len, pos);
+			if (wres < 0) {
+				if (ErrCode() == EINTR)
+					continue;
+				return ErrCode();
+			}
+			if (wres == 0)
+				return EIO;
+			ptr += wres;
+			pos += wres;
+			len -= wres;
+		}
+	}
+	return MDB_SUCCESS;
+}
+
+	/** Submit the queued entries and reap completions until at least
+	 *	\b want slots are free and, when \b want is the whole depth, the
+	 *	data sync is done too. After an error everything in flight is
+	 *	still waited for: the kernel reads the dirty pages until then.
+	 *	When io_uring_enter() itself fails, the entries it did not take
+	 *	are taken back out of the SQ and the rest is only reaped. If even
+	 *	that fails, ur_busy is left above 0.
+	 */
+static int
+mdb_uring_wait(MDB_uring *ur, HANDLE fd, unsigned want)
+{
+	struct io_uring_cqe *cqe;
+	MDB_uring_slot *us;
+	unsigned head, slot;
+	int rc = MDB_SUCCESS, ret, err;
+
+	for (;;) {
+		head = *ur->ur_cqhead;
+		while (head != __atomic_load_n(ur->ur_cqtail, __ATOMIC_ACQUIRE)) {
+			cqe = &ur->ur_cqes[head & *ur->ur_cqmask];
+			ur->ur_busy--;
+			if (cqe->user_data == MDB_URING_SYNC) {
+				if (cqe->res < 0 && !rc)
+					rc = -cqe->res;
+			} else {
+				slot = (unsigned)cqe->user_data;
+				us = &ur->ur_slots[slot];
+				if (cqe->res != (ssize_t)us->us_size && !rc) {
+					if (cqe->res >= 0 || cqe->res == -EINTR || cqe->res == -EAGAIN) {
+						rc = mdb_uring_rest(fd, ur->ur_iov + (size_t)slot * MDB_COMMIT_PAGES,
+							us->us_n, us->us_pos, cqe->res > 0 ? cqe->res : 0);
+						ur->ur_resync = 1;
+					} else {
+						rc = -cqe->res;
+						DPRINTF(("io_uring write error: %s", strerror(rc)));
+					}
+				}
+				ur->ur_free[ur->ur_nfree++] = slot;
+			}
+			head++;
+		}
+		__atomic_store_n(ur->ur_cqhead, head, __ATOMIC_RELEASE);
+		if (rc)
+			want = ur->ur_depth;
+		if (!ur->ur_queued && (want < ur->ur_depth ? ur->ur_nfree >= want : !ur->ur_busy))
+			break;
+		ret = syscall(__NR_io_uring_enter, ur->ur_fd, ur->ur_queued, 1,
+			IORING_ENTER_GETEVENTS, NULL, 0);
+		if (ret < 0) {
+			err = ErrCode();
+			if (err == EINTR || err == EAGAIN || err == EBUSY)
+				continue;
+			if (!rc)
+				rc = err;
+			if (ur->ur_broken)
+				break;
+			/* Never leave stale entries behind for the next commit */
+			head = __atomic_load_n(ur->ur_sqhead, __ATOMIC_ACQUIRE);
+			ur->ur_busy -= *ur->ur_sqtail - head;
+			ur->ur_queued = 0;
+			__atomic_store_n(ur->ur_sqtail, head, __ATOMIC_RELEASE);
+			ur->ur_broken = 1;
+			continue;
+		}
+		ur->ur_queued -= ret;
+	}
+	return rc;
+}
+
+	/** Queue the write of one run of pages, like a pwritev() call */
+static int
+mdb_uring_write(MDB_uring *ur, HANDLE fd, struct iovec *iov, int n, off_t pos, size_t size)
+{
+	struct io_uring_sqe *sqe;
+	unsigned slot;
+	int rc;
+
+	/* Refill in batches, not one submission per completion */
+	if (!ur->ur_nfree && (rc = mdb_uring_wait(ur, fd, (ur->ur_depth + 1) / 2)))
+		return rc;
+	slot = ur->ur_free[--ur->ur_nfree];
+	memcpy(ur->ur_iov + (size_t)slot * MDB_COMMIT_PAGES, iov, n * sizeof(struct iovec));
+	ur->ur_slots[slot].us_pos = pos;
+	ur->ur_slots[slot].us_size = size;
+	ur->ur_slots[slot].us_n = n;
+	sqe = mdb_uring_sqe(ur);
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->addr = (__u64)(uintptr_t)(ur->ur_iov + (size_t)slot * MDB_COMMIT_PAGES);
+	sqe->len = n;
+	sqe->off = pos;
+	sqe->user_data = slot;
+	return MDB_SUCCESS;
+}
+
+	/** Wait for all queued writes. With \b sync a data sync goes along,
+	 *	drained behind the writes so one submission covers both.
+	 */
+static int
+mdb_uring_finish(MDB_env *env, MDB_uring *ur, int sync)
+{
+	struct io_uring_sqe *sqe;
+	int rc;
+
+	ur->ur_resync = 0;
+	if (sync) {
+		sqe = mdb_uring_sqe(ur);
+		sqe->opcode = IORING_OP_FSYNC;
+		sqe->fd = env->me_fd;
+#ifdef BROKEN_FDATASYNC
+		if (!(env->me_flags & MDB_FSYNCONLY))
+#endif
+		sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+		sqe->flags = IOSQE_IO_DRAIN;
+		sqe->user_data = MDB_URING_SYNC;
+	}
+	rc = mdb_uring_wait(ur, env->me_fd, ur->ur_depth);
+	/* pages finished by pwrite() may have missed the sync */
+	if (!rc && sync && ur->ur_resync)
+		rc = mdb_env_sync(env, 1);
+	return rc;
+}
+
+	/** After a failed flush, give up a ring io_uring_enter() failed on.
+	 *	Later commits use pwritev(). If writes from the dirty pages the
+	 *	abort is about to free may still be in flight, the env is dead.
+	 */
+static void
+mdb_uring_drop(MDB_env *env)
+{
+	MDB_uring *ur = env->me_uring;
+
+	if (!ur->ur_broken)
+		return;
+	if (ur->ur_busy) {
+		env->me_flags |= MDB_FATAL_ERROR;
+		DPUTS("io_uring writes could not be drained");
+		return;
+	}
+	mdb_uring_free(ur);
+	env->me_uring = NULL;
+}
+#endif	/* MDB_USE_IO_URING */
+
 /** Flush (some) dirty pages to the map, after clearing their dirty flag.
  * @param[in] txn the transaction that's being committed
  * @param[in] keep number of initial pages in dirty_list to keep dirty.
+ * @param[out] synced if not NULL, set when the data sync of the commit
+ * was done along with the writes, see #mdb_env_set_uring().
  * @return 0 on success, non-zero on failure.
  */
 static int
-mdb_page_flush(MDB_txn *txn, int keep)
+mdb_page_flush(MDB_txn *txn, int keep, int *synced)
 {
 	MDB_env		*env = txn->mt_env;
 	MDB_ID2L	dl = txn->mt_u.dirty_list;
@@ -3338,8 +4273,14 @@ mdb_page_flush(MDB_txn *txn, int keep)
 	size_t		next_pos = 1; /* impossible pos, so pos != next_pos */
 	int			n = 0;
 #endif
+#if MDB_USE_IO_URING
+	MDB_uring	*ur = env->me_uring;
+#endif
 
+	mdb_dirty_sort(txn);
 	j = i = keep;
+	if (synced)
+		*synced = 0;
 
 	if (env->me_flags & MDB_WRITEMAP) {
 		/* Clear dirty flags */
@@ -3396,6 +4337,16 @@ mdb_page_flush(MDB_txn *txn, int keep)
 		/* Write up to MDB_COMMIT_PAGES dirty pages at a time. */
 		if (pos!=next_pos || n==MDB_COMMIT_PAGES || wsize+size>MAX_WRITE) {
 			if (n) {
+#if MDB_USE_IO_URING
+				if (ur) {
+					if ((rc = mdb_uring_write(ur, env->me_fd, iov, n, wpos, wsize))) {
+						mdb_uring_drop(env);
+						return rc;
+					}
+					n = 0;
+				}
+				if (n) {
+#endif
 retry_write:
 				/* Write previous page(s) */
 #ifdef MDB_USE_PWRITEV
@@ -3428,6 +4379,9 @@ retry_seek:
 					return rc;
 				}
 				n = 0;
+#if MDB_USE_IO_URING
+				}
+#endif
 			}
 			if (i > pagecount)
 				break;
@@ -3443,6 +4397,18 @@ retry_seek:
 #endif	/* _WIN32 */
 	}
 
+#if MDB_USE_IO_URING
+	if (ur) {
+		int sync = synced && !(env->me_flags & MDB_NOSYNC);
+		if ((rc = mdb_uring_finish(env, ur, sync))) {
+			mdb_uring_drop(env);
+			return rc;
+		}
+		if (synced)
+			*synced = 1;
+	}
+#endif
+
 	/* MIPS has cache coherency issues, this is a no-op everywhere else
 	 * Note: for any size >= on-chip cache size, entire on-chip cache is
 	 * flushed.
@@ -3464,13 +4430,15 @@ done:
 	i--;
 	txn->mt_dirty_room += i - j;
 	dl[0].mid = j;
+	if (!txn->mt_parent)
+		mdb_dirty_reindex(txn);
 	return MDB_SUCCESS;
 }
 
 int
 mdb_txn_commit(MDB_txn *txn)
 {
-	int		rc;
+	int		rc, synced;
 	unsigned int i, end_mode;
 	MDB_env	*env;
 
@@ -3604,6 +4572,8 @@ mdb_txn_commit(MDB_txn *txn)
 		}
 		mdb_tassert(txn, i == x);
 		dst[0].mid = len;
+		if (!parent->mt_parent)
+			mdb_dirty_reindex(parent);
 		free(txn->mt_u.dirty_list);
 		parent->mt_dirty_room = txn->mt_dirty_room;
 		if (txn->mt_spill_pgs) {
@@ -3681,8 +4651,8 @@ mdb_txn_commit(MDB_txn *txn)
 	mdb_audit(txn);
 #endif
 
-	if ((rc = mdb_page_flush(txn, 0)) ||
-		(rc = mdb_env_sync(env, 0)) ||
+	if ((rc = mdb_page_flush(txn, 0, &synced)) ||
+		(!synced && (rc = mdb_env_sync(env, 0))) ||
 		(rc = mdb_env_write_meta(txn)))
 		goto fail;
 	end_mode = MDB_END_COMMITTED|MDB_END_UPDATE;
@@ -3981,6 +4951,7 @@ mdb_env_create(MDB_env **env)
 
 	e->me_maxreaders = DEFAULT_READERS;
 	e->me_maxdbs = e->me_numdbs = CORE_DBS;
+	e->me_dirty_max = MDB_IDL_UM_MAX;
 	e->me_fd = INVALID_HANDLE_VALUE;
 	e->me_lfd = INVALID_HANDLE_VALUE;
 	e->me_mfd = INVALID_HANDLE_VALUE;
@@ -5003,8 +5974,10 @@ mdb_env_open(MDB_env *env, const char *path, unsigned int flags, mdb_mode_t mode
 		flags &= ~MDB_WRITEMAP;
 	} else {
 		if (!((env->me_free_pgs = mdb_midl_alloc(MDB_IDL_UM_MAX)) &&
-			  (env->me_dirty_list = calloc(MDB_IDL_UM_SIZE, sizeof(MDB_ID2)))))
+			  (env->me_dirty_list = calloc(MDB_IDL_UM_SIZE, sizeof(MDB_ID2))) &&
+			  !mdb_dirty_ixalloc(env, MDB_IDL_UM_MAX)))
 			rc = ENOMEM;
+		env->me_dirty_cap = MDB_IDL_UM_MAX;
 	}
 	env->me_flags = flags |= MDB_ENV_ACTIVE;
 	if (rc)
@@ -5019,6 +5992,7 @@ mdb_env_open(MDB_env *env, const char *path, unsigned int flags, mdb_mode_t mode
 		goto leave;
 	}
 	env->me_dbxs[FREE_DBI].md_cmp = mdb_cmp_long; /* aligned MDB_INTEGERKEY */
+	env->me_dbxs[FREE_DBI].md_search = mdb_search_long;
 
 	/* For RDONLY, get lockfile after we know datafile exists */
 	if (!(flags & (MDB_RDONLY|MDB_NOLOCK))) {
@@ -5104,6 +6078,8 @@ mdb_env_close0(MDB_env *env, int excl)
 	free(env->me_dbflags);
 	free(env->me_path);
 	free(env->me_dirty_list);
+	free(env->me_dirty_ix);
+	mdb_pgruns_free(&env->me_pgruns);
 	free(env->me_txn0);
 	mdb_midl_free(env->me_free_pgs);
 
@@ -5207,6 +6183,9 @@ mdb_env_close(MDB_env *env)
 	}
 
 	mdb_env_close0(env, 0);
+#if MDB_USE_IO_URING
+	mdb_uring_free(env->me_uring);
+#endif
 	free(env);
 }
 
@@ -5305,6 +6284,266 @@ mdb_cmp_memnr(const MDB_val *a, const MDB_val *b)
 	return len_diff<0 ? -1 : len_diff;
 }
 
+/** Define a node search loop with comparator \b CMP called directly.
+ *	Stops at the first exact match, otherwise leaves the index and
+ *	compare result of the last probe for #mdb_node_search().
+ */
+#define MDB_SEARCH_FUNC(name, CMP)	\
+static unsigned	\
+name(MDB_page *mp, int low, int high, MDB_val *key, MDB_cmp_func *cmp,	\
+	MDB_node **nodep, int *rcp)	\
+{	\
+	unsigned int i = 0;	\
+	int rc = 0;	\
+	MDB_node *node = NULL;	\
+	MDB_val nodekey;	\
+	while (low <= high) {	\
+		i = (low + high) >> 1;	\
+		node = NODEPTR(mp, i);	\
+		nodekey.mv_size = NODEKSZ(node);	\
+		nodekey.mv_data = NODEKEY(node);	\
+		rc = CMP(key, &nodekey);	\
+		if (rc == 0)	\
+			break;	\
+		if (rc > 0)	\
+			low = i + 1;	\
+		else	\
+			high = i - 1;	\
+	}	\
+	*nodep = node;	\
+	*rcp = rc;	\
+	return i;	\
+}
+
+MDB_SEARCH_FUNC(mdb_search_memn, mdb_cmp_memn)
+MDB_SEARCH_FUNC(mdb_search_memnr, mdb_cmp_memnr)
+MDB_SEARCH_FUNC(mdb_search_int, mdb_cmp_int)
+MDB_SEARCH_FUNC(mdb_search_cint, mdb_cmp_cint)
+MDB_SEARCH_FUNC(mdb_search_long, mdb_cmp_long)
+MDB_SEARCH_FUNC(mdb_search_generic, cmp)
+
+/** Return the search loop for comparator \b cmp.
+ *	Custom comparators get #mdb_search_generic().
+ */
+static MDB_search_func *
+mdb_cmp_search(MDB_cmp_func *cmp)
+{
+	return cmp == mdb_cmp_memn ? mdb_search_memn :
+		cmp == mdb_cmp_memnr ? mdb_search_memnr :
+		cmp == mdb_cmp_int ? mdb_search_int :
+		cmp == mdb_cmp_cint ? mdb_search_cint :
+		cmp == mdb_cmp_long ? mdb_search_long : mdb_search_generic;
+}
+
+#if MDB_SIMD_SEARCH
+	/** Key layouts the vector search understands. The built-in integer
+	 *	comparators order native unsigned values, #mdb_cmp_memn on fixed
+	 *	size keys orders them as big-endian unsigned values.
+	 */
+enum {
+	MDB_SK_NONE,
+	MDB_SK_U32,		/**< native unsigned int */
+	MDB_SK_U64,		/**< native size_t */
+	MDB_SK_BE32,	/**< 4 bytes in memcmp order */
+	MDB_SK_BE64		/**< 8 bytes in memcmp order */
+};
+
+	/** Ranges at most this long are finished with a vector scan */
+#define MDB_SIMD_WINDOW	32
+
+	/** The level in effect, -1 until detected. Readers of every thread
+	 *	load it, so it is only accessed with relaxed atomics.
+	 */
+static int mdb_simd_level = -1;
+
+static int
+mdb_simd_detect(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return MDB_SIMD_AVX2;
+	if (__builtin_cpu_supports("sse4.2"))
+		return MDB_SIMD_SSE42;
+	return MDB_SIMD_NONE;
+}
+
+int ESECT
+mdb_set_simd(int level)
+{
+	int hw = mdb_simd_detect();
+	if (level < 0 || level > hw)
+		level = hw;
+	__atomic_store_n(&mdb_simd_level, level, __ATOMIC_RELAXED);
+	return level;
+}
+
+/** Return the #MDB_SK_* layout for keys of size \b ksize compared by \b cmp */
+static int
+mdb_simd_kind(MDB_cmp_func *cmp, size_t ksize)
+{
+	int level = __atomic_load_n(&mdb_simd_level, __ATOMIC_RELAXED);
+
+	if (level < 0) {
+		/* First search: detect, unless mdb_set_simd() got there first */
+		int unset = -1;
+		level = mdb_simd_detect();
+		if (!__atomic_compare_exchange_n(&mdb_simd_level, &unset, level, 0,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			level = unset;
+	}
+	if (level == MDB_SIMD_NONE)
+		return MDB_SK_NONE;
+	if (ksize == sizeof(unsigned int) &&
+		(cmp == mdb_cmp_int || cmp == mdb_cmp_cint))
+		return MDB_SK_U32;
+	if (ksize == sizeof(size_t) && sizeof(size_t) == 8 &&
+		(cmp == mdb_cmp_long || cmp == mdb_cmp_clong || cmp == mdb_cmp_cint))
+		return MDB_SK_U64;
+	if (cmp == mdb_cmp_memn) {
+		if (ksize == 4)
+			return MDB_SK_BE32;
+		if (ksize == 8)
+			return MDB_SK_BE64;
+	}
+	return MDB_SK_NONE;
+}
+
+/** Load a key as an unsigned value that orders like its comparator */
+static uint64_t
+mdb_simd_load(const void *p, int kind)
+{
+	uint32_t u32;
+	uint64_t u64;
+	switch (kind) {
+	case MDB_SK_U32:
+		memcpy(&u32, p, 4);
+		return u32;
+	case MDB_SK_BE32:
+		memcpy(&u32, p, 4);
+		return __builtin_bswap32(u32);
+	case MDB_SK_U64:
+		memcpy(&u64, p, 8);
+		return u64;
+	default:
+		memcpy(&u64, p, 8);
+		return __builtin_bswap64(u64);
+	}
+}
+
+/** Count the leading keys of the sorted run \b base[0..n) that are less than \b key */
+static unsigned
+mdb_simd_rank_scalar(const char *base, unsigned n, uint64_t key, int kind, size_t ksize)
+{
+	unsigned i;
+	for (i = 0; i < n && mdb_simd_load(base + i * ksize, kind) < key; i++)
+		;
+	return i;
+}
+
+__attribute__((target("sse4.2"))) static unsigned
+mdb_simd_rank_sse42(const char *base, unsigned n, uint64_t key, int kind, size_t ksize)
+{
+	unsigned i = 0, mask;
+	if (ksize == 4) {
+		const __m128i sign = _mm_set1_epi32((int)0x80000000);
+		const __m128i bswap = _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+		__m128i k = _mm_xor_si128(_mm_set1_epi32((int)(uint32_t)key), sign), v;
+		for (; i + 4 <= n; i += 4) {
+			v = _mm_loadu_si128((const __m128i *)(base + i * 4));
+			if (kind == MDB_SK_BE32)
+				v = _mm_shuffle_epi8(v, bswap);
+			v = _mm_xor_si128(v, sign);
+			mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k, v)));
+			if (mask != 0xf)
+				return i + __builtin_popcount(mask);
+		}
+	} else {
+		const __m128i sign = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+		const __m128i bswap = _mm_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+		__m128i k = _mm_xor_si128(_mm_set1_epi64x((long long)key), sign), v;
+		for (; i + 2 <= n; i += 2) {
+			v = _mm_loadu_si128((const __m128i *)(base + i * 8));
+			if (kind == MDB_SK_BE64)
+				v = _mm_shuffle_epi8(v, bswap);
+			v = _mm_xor_si128(v, sign);
+			mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(k, v)));
+			if (mask != 0x3)
+				return i + __builtin_popcount(mask);
+		}
+	}
+	return i + mdb_simd_rank_scalar(base + i * ksize, n - i, key, kind, ksize);
+}
+
+__attribute__((target("avx2"))) static unsigned
+mdb_simd_rank_avx2(const char *base, unsigned n, uint64_t key, int kind, size_t ksize)
+{
+	unsigned i = 0, mask;
+	if (ksize == 4) {
+		const __m256i sign = _mm256_set1_epi32((int)0x80000000);
+		const __m256i bswap = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+			3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+		__m256i k = _mm256_xor_si256(_mm256_set1_epi32((int)(uint32_t)key), sign), v;
+		for (; i + 8 <= n; i += 8) {
+			v = _mm256_loadu_si256((const __m256i *)(base + i * 4));
+			if (kind == MDB_SK_BE32)
+				v = _mm256_shuffle_epi8(v, bswap);
+			v = _mm256_xor_si256(v, sign);
+			mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v)));
+			if (mask != 0xff)
+				return i + __builtin_popcount(mask);
+		}
+	} else {
+		const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+		const __m256i bswap = _mm256_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8,
+			7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+		__m256i k = _mm256_xor_si256(_mm256_set1_epi64x((long long)key), sign), v;
+		for (; i + 4 <= n; i += 4) {
+			v = _mm256_loadu_si256((const __m256i *)(base + i * 8));
+			if (kind == MDB_SK_BE64)
+				v = _mm256_shuffle_epi8(v, bswap);
+			v = _mm256_xor_si256(v, sign);
+			mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)));
+			if (mask != 0xf)
+				return i + __builtin_popcount(mask);
+		}
+	}
+	return i + mdb_simd_rank_sse42(base + i * ksize, n - i, key, kind, ksize);
+}
+
+/** Find the first key in \b mp[low..nkeys) that is not less than \b key.
+ *	The range is halved with inline integer compares until it fits
+ *	in #MDB_SIMD_WINDOW keys, then finished with a vector scan.
+ *	@param[out] exactp set if the key at the returned index equals \b key
+ */
+static unsigned
+mdb_simd_search(MDB_page *mp, unsigned low, MDB_val *key, int kind, int *exactp)
+{
+	size_t ksize = (kind == MDB_SK_U32 || kind == MDB_SK_BE32) ? 4 : 8;
+	unsigned nkeys = NUMKEYS(mp), high = nkeys, mid;
+	uint64_t k = mdb_simd_load(key->mv_data, kind);
+
+	while (high - low > MDB_SIMD_WINDOW) {
+		mid = (low + high) >> 1;
+		if (mdb_simd_load(LEAF2KEY(mp, mid, ksize), kind) < k)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (__atomic_load_n(&mdb_simd_level, __ATOMIC_RELAXED) == MDB_SIMD_AVX2)
+		low += mdb_simd_rank_avx2(LEAF2KEY(mp, low, ksize), high - low, k, kind, ksize);
+	else
+		low += mdb_simd_rank_sse42(LEAF2KEY(mp, low, ksize), high - low, k, kind, ksize);
+	*exactp = low < nkeys && mdb_simd_load(LEAF2KEY(mp, low, ksize), kind) == k;
+	return low;
+}
+#else
+int ESECT
+mdb_set_simd(int level)
+{
+	return MDB_SIMD_NONE;
+}
+#endif /* MDB_SIMD_SEARCH */
+
 /** Search for key within a page, using binary search.
  * Returns the smallest entry larger or equal to the key.
  * If exactp is non-null, stores whether the found entry was an exact match
@@ -5322,6 +6561,7 @@ mdb_node_search(MDB_cursor *mc, MDB_val *key, int *exactp)
 	MDB_node	*node = NULL;
 	MDB_val	 nodekey;
 	MDB_cmp_func *cmp;
+	MDB_search_func *search;
 	DKBUF;
 
 	nkeys = NUMKEYS(mp);
@@ -5333,20 +6573,34 @@ mdb_node_search(MDB_cursor *mc, MDB_val *key, int *exactp)
 	low = IS_LEAF(mp) ? 0 : 1;
 	high = nkeys - 1;
 	cmp = mc->mc_dbx->md_cmp;
+	search = mc->mc_dbx->md_search;
 
 	/* Branch pages have no data, so if using integer keys,
 	 * alignment is guaranteed. Use faster mdb_cmp_int.
 	 */
 	if (cmp == mdb_cmp_cint && IS_BRANCH(mp)) {
-		if (NODEPTR(mp, 1)->mn_ksize == sizeof(size_t))
+		if (NODEPTR(mp, 1)->mn_ksize == sizeof(size_t)) {
 			cmp = mdb_cmp_long;
-		else
+			search = mdb_search_long;
+		} else {
 			cmp = mdb_cmp_int;
+			search = mdb_search_int;
+		}
 	}
 
 	if (IS_LEAF2(mp)) {
 		nodekey.mv_size = mc->mc_db->md_pad;
 		node = NODEPTR(mp, 0);	/* fake */
+#if MDB_SIMD_SEARCH
+		if (key->mv_size == nodekey.mv_size) {
+			int kind = mdb_simd_kind(cmp, nodekey.mv_size), exact;
+			if (kind != MDB_SK_NONE) {
+				i = mdb_simd_search(mp, low, key, kind, &exact);
+				rc = exact ? 0 : -1;
+				high = -1;	/* skip the scalar search */
+			}
+		}
+#endif
 		while (low <= high) {
 			i = (low + high) >> 1;
 			nodekey.mv_data = LEAF2KEY(mp, i, nodekey.mv_size);
@@ -5361,29 +6615,19 @@ mdb_node_search(MDB_cursor *mc, MDB_val *key, int *exactp)
 				high = i - 1;
 		}
 	} else {
-		while (low <= high) {
-			i = (low + high) >> 1;
-
-			node = NODEPTR(mp, i);
+		i = search(mp, low, high, key, cmp, &node, &rc);
+#if MDB_DEBUG
+		if (node) {
 			nodekey.mv_size = NODEKSZ(node);
 			nodekey.mv_data = NODEKEY(node);
-
-			rc = cmp(key, &nodekey);
-#if MDB_DEBUG
 			if (IS_LEAF(mp))
 				DPRINTF(("found leaf index %u [%s], rc = %i",
 				    i, DKEY(&nodekey), rc));
 			else
 				DPRINTF(("found branch index %u [%s -> %"Z"u], rc = %i",
 				    i, DKEY(&nodekey), NODEPGNO(node), rc));
-#endif
-			if (rc == 0)
-				break;
-			if (rc > 0)
-				low = i + 1;
-			else
-				high = i - 1;
 		}
+#endif
 	}
 
 	if (rc > 0) {	/* Found entry is less than the key. */
@@ -5491,8 +6735,8 @@ mdb_page_get(MDB_cursor *mc, pgno_t pgno, MDB_page **ret, int *lvl)
 				}
 			}
 			if (dl[0].mid) {
-				unsigned x = mdb_mid2l_search(dl, pgno);
-				if (x <= dl[0].mid && dl[x].mid == pgno) {
+				unsigned x = mdb_dirty_find(tx2, pgno);
+				if (x) {
 					p = dl[x].mptr;
 					goto done;
 				}
@@ -5517,6 +6761,59 @@ done:
 	return MDB_SUCCESS;
 }
 
+/** Move down from the branch page at the top of the cursor to the child
+ * that covers \b key, or the first or last child with #MDB_PS_FIRST or
+ * #MDB_PS_LAST, and prefetch the child.
+ *	@param[in,out] mc the cursor.
+ *	@param[in] key the key to search for, unused with #MDB_PS_FIRST or
+ *	#MDB_PS_LAST.
+ *	@param[in] flags #MDB_PS_FIRST, #MDB_PS_LAST or 0.
+ *	@return 0 on success, non-zero on failure.
+ */
+static int
+mdb_page_search_step(MDB_cursor *mc, MDB_val *key, int flags)
+{
+	MDB_page	*mp = mc->mc_pg[mc->mc_top];
+	MDB_node	*node;
+	indx_t		 i;
+	int		 rc;
+	DKBUF;
+
+	if (flags & (MDB_PS_FIRST|MDB_PS_LAST)) {
+		i = (flags & MDB_PS_LAST) ? NUMKEYS(mp) - 1 : 0;
+	} else {
+		int	 exact;
+		node = mdb_node_search(mc, key, &exact);
+		if (node == NULL)
+			i = NUMKEYS(mp) - 1;
+		else {
+			i = mc->mc_ki[mc->mc_top];
+			if (!exact) {
+				mdb_cassert(mc, i > 0);
+				i--;
+			}
+		}
+		DPRINTF(("following index %u for key [%s]", i, DKEY(key)));
+	}
+
+	mdb_cassert(mc, i < NUMKEYS(mp));
+	node = NODEPTR(mp, i);
+
+	if ((rc = mdb_page_get(mc, NODEPGNO(node), &mp, NULL)) != 0)
+		return rc;
+	/* The header and the index of up to ~120 keys are read back to back
+	 * by mdb_node_search (or #mdb_page_prime()), fetch them together.
+	 */
+	MDB_PREFETCH(mp);
+	MDB_PREFETCH((char *)mp + 64);
+	MDB_PREFETCH((char *)mp + 128);
+	MDB_PREFETCH((char *)mp + 192);
+	MDB_PREFETCH((char *)mp + 256);
+
+	mc->mc_ki[mc->mc_top] = i;
+	return mdb_cursor_push(mc, mp);
+}
+
 /** Finish #mdb_page_search() / #mdb_page_search_lowest().
  *	The cursor is at the root page, set up the rest of it.
  */
@@ -5528,9 +6825,6 @@ mdb_page_search_root(MDB_cursor *mc, MDB_val *key, int flags)
 	DKBUF;
 
 	while (IS_BRANCH(mp)) {
-		MDB_node	*node;
-		indx_t		i;
-
 		DPRINTF(("branch page %"Z"u has %u keys", mp->mp_pgno, NUMKEYS(mp)));
 		/* Don't assert on branch pages in the FreeDB. We can get here
 		 * while in the process of rebalancing a FreeDB branch page; we must
@@ -5539,50 +6833,20 @@ mdb_page_search_root(MDB_cursor *mc, MDB_val *key, int flags)
 		mdb_cassert(mc, !mc->mc_dbi || NUMKEYS(mp) > 1);
 		DPRINTF(("found index 0 to page %"Z"u", NODEPGNO(NODEPTR(mp, 0))));
 
-		if (flags & (MDB_PS_FIRST|MDB_PS_LAST)) {
-			i = 0;
-			if (flags & MDB_PS_LAST) {
-				i = NUMKEYS(mp) - 1;
-				/* if already init'd, see if we're already in right place */
-				if (mc->mc_flags & C_INITIALIZED) {
-					if (mc->mc_ki[mc->mc_top] == i) {
-						mc->mc_top = mc->mc_snum++;
-						mp = mc->mc_pg[mc->mc_top];
-						goto ready;
-					}
-				}
-			}
-		} else {
-			int	 exact;
-			node = mdb_node_search(mc, key, &exact);
-			if (node == NULL)
-				i = NUMKEYS(mp) - 1;
-			else {
-				i = mc->mc_ki[mc->mc_top];
-				if (!exact) {
-					mdb_cassert(mc, i > 0);
-					i--;
-				}
-			}
-			DPRINTF(("following index %u for key [%s]", i, DKEY(key)));
-		}
-
-		mdb_cassert(mc, i < NUMKEYS(mp));
-		node = NODEPTR(mp, i);
-
-		if ((rc = mdb_page_get(mc, NODEPGNO(node), &mp, NULL)) != 0)
-			return rc;
-
-		mc->mc_ki[mc->mc_top] = i;
-		if ((rc = mdb_cursor_push(mc, mp)))
+		/* if already init'd, see if we're already in right place */
+		if ((flags & MDB_PS_LAST) && (mc->mc_flags & C_INITIALIZED) &&
+			mc->mc_ki[mc->mc_top] == NUMKEYS(mp) - 1) {
+			mc->mc_top = mc->mc_snum++;
+		} else if ((rc = mdb_page_search_step(mc, key,
+			flags & (MDB_PS_FIRST|MDB_PS_LAST))) != 0) {
 			return rc;
+		}
 
-ready:
 		if (flags & MDB_PS_MODIFY) {
 			if ((rc = mdb_page_touch(mc)) != 0)
 				return rc;
-			mp = mc->mc_pg[mc->mc_top];
 		}
+		mp = mc->mc_pg[mc->mc_top];
 	}
 
 	if (!IS_LEAF(mp)) {
@@ -5735,8 +6999,8 @@ mdb_ovpage_free(MDB_cursor *mc, MDB_page *mp)
 		 (sl && (x = mdb_midl_search(sl, pn)) <= sl[0] && sl[x] == pn)))
 	{
 		unsigned i, j;
-		pgno_t *mop;
-		MDB_ID2 *dl, ix, iy;
+		pgno_t *mop, *mop0 = env->me_pghead, mop_len = mop0[0];
+		MDB_ID2 *dl;
 		rc = mdb_midl_need(&env->me_pghead, ovpages);
 		if (rc)
 			return rc;
@@ -5750,20 +7014,13 @@ mdb_ovpage_free(MDB_cursor *mc, MDB_page *mp)
 		}
 		/* Remove from dirty list */
 		dl = txn->mt_u.dirty_list;
-		x = dl[0].mid--;
-		for (ix = dl[x]; ix.mptr != mp; ix = iy) {
-			if (x > 1) {
-				x--;
-				iy = dl[x];
-				dl[x] = ix;
-			} else {
-				mdb_cassert(mc, x > 1);
-				j = ++(dl[0].mid);
-				dl[j] = ix;		/* Unsorted. OK when MDB_TXN_ERROR. */
-				txn->mt_flags |= MDB_TXN_ERROR;
-				return MDB_CORRUPTED;
-			}
+		x = mdb_dirty_find(txn, pg);
+		if (!x || dl[x].mptr != mp) {
+			mdb_cassert(mc, x != 0);
+			txn->mt_flags |= MDB_TXN_ERROR;
+			return MDB_CORRUPTED;
 		}
+		mdb_dirty_remove(txn, x);
 		txn->mt_dirty_room++;
 		if (!(env->me_flags & MDB_WRITEMAP))
 			mdb_dpage_free(env, mp);
@@ -5776,6 +7033,7 @@ release:
 		while (j>i)
 			mop[j--] = pg++;
 		mop[0] += ovpages;
+		mdb_pgruns_note(env, mop0, mop_len, NULL, pg - ovpages, ovpages, 1);
 	} else {
 		rc = mdb_midl_append_range(&txn->mt_free_pgs, pg, ovpages);
 		if (rc)
@@ -5838,6 +7096,127 @@ mdb_get(MDB_txn *txn, MDB_dbi dbi,
 	return mdb_cursor_set(&mc, key, data, MDB_SET, &exact);
 }
 
+/** Lookups kept in flight by #mdb_get_batch(). */
+#ifndef MDB_BATCH_WIDTH
+#define MDB_BATCH_WIDTH	8
+#endif
+
+/** Prefetch the nodes the first four rounds of the binary search in
+ * #mdb_node_search() will probe. Reads the page's index, so the page
+ * header should have been prefetched a while before.
+ */
+static void
+mdb_page_prime(MDB_page *mp)
+{
+	int lo[15], hi[15], k, n = 1;
+
+	lo[0] = IS_LEAF(mp) ? 0 : 1;
+	hi[0] = NUMKEYS(mp) - 1;
+	for (k = 0; k < n; k++) {
+		int mid;
+		if (lo[k] > hi[k])
+			continue;
+		mid = (lo[k] + hi[k]) >> 1;
+		MDB_PREFETCH(NODEPTR(mp, mid));
+		if (n < 15) {
+			lo[n] = lo[k];
+			hi[n++] = mid - 1;
+		}
+		if (n < 15) {
+			lo[n] = mid + 1;
+			hi[n++] = hi[k];
+		}
+	}
+}
+
+int
+mdb_get_batch(MDB_txn *txn, MDB_dbi dbi, MDB_val *keys, MDB_val *data,
+	int *rcs, unsigned int n)
+{
+	MDB_cursor	mc[MDB_BATCH_WIDTH];
+	unsigned int slot[MDB_BATCH_WIDTH];
+	char primed[MDB_BATCH_WIDTH];
+	unsigned int i, next = 0, active = 0;
+	int rc, exact;
+
+	if (!keys || !data || !rcs || !TXN_DBI_EXIST(txn, dbi, DB_USRVALID))
+		return EINVAL;
+
+	if (txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+
+	if (txn->mt_dbs[dbi].md_flags & MDB_DUPSORT) {
+		for (i = 0; i < n; i++)
+			rcs[i] = mdb_get(txn, dbi, &keys[i], &data[i]);
+		return MDB_SUCCESS;
+	}
+
+	for (i = 0; i < MDB_BATCH_WIDTH; i++)
+		slot[i] = n;
+
+	/* Round robin over the slots: a free slot starts the next key at
+	 * the root. A busy one first prefetches the search probes of its
+	 * page, then on the next round moves down a level (prefetching the
+	 * child) or finishes at the leaf. By the time a slot comes around
+	 * again what it prefetched has arrived.
+	 */
+	while (next < n || active) {
+		for (i = 0; i < MDB_BATCH_WIDTH; i++) {
+			MDB_cursor *m = &mc[i];
+			unsigned int k = slot[i];
+			MDB_page *mp;
+			MDB_node *leaf;
+
+			if (k == n) {
+				if (next == n)
+					continue;
+				k = next++;
+				if (keys[k].mv_size == 0) {
+					rcs[k] = MDB_BAD_VALSIZE;
+					continue;
+				}
+				mdb_cursor_init(m, txn, dbi, NULL);
+				rc = mdb_page_search(m, &keys[k], MDB_PS_ROOTONLY);
+				if (rc != MDB_SUCCESS) {
+					rcs[k] = rc;
+					continue;
+				}
+				slot[i] = k;
+				primed[i] = 0;
+				active++;
+				continue;
+			}
+			mp = m->mc_pg[m->mc_top];
+			if (!primed[i]) {
+				mdb_page_prime(mp);
+				primed[i] = 1;
+				continue;
+			}
+			if (IS_BRANCH(mp)) {
+				rc = mdb_page_search_step(m, &keys[k], 0);
+				primed[i] = 0;
+				if (rc == MDB_SUCCESS)
+					continue;
+			} else if (!IS_LEAF(mp)) {
+				DPRINTF(("internal error, index points to a %02X page!?",
+				    mp->mp_flags));
+				txn->mt_flags |= MDB_TXN_ERROR;
+				rc = MDB_CORRUPTED;
+			} else {
+				leaf = mdb_node_search(m, &keys[k], &exact);
+				if (leaf && exact)
+					rc = mdb_node_read(m, leaf, &data[k]);
+				else
+					rc = MDB_NOTFOUND;
+			}
+			rcs[k] = rc;
+			slot[i] = n;
+			active--;
+		}
+	}
+	return MDB_SUCCESS;
+}
+
 /** Find a sibling for a page.
  * Replaces the page at the top of the cursor's stack with the
  * specified sibling, if one exists.
@@ -6158,6 +7537,32 @@ mdb_cursor_set(MDB_cursor *mc, MDB_val *key, MDB_val *data,
 				mc->mc_ki[mc->mc_top] = nkeys;
 				return MDB_NOTFOUND;
 			}
+			{
+				/* The key is past this leaf. Find the lowest branch
+				 * whose current child still covers it and descend from
+				 * that child, so nearby keys skip the upper levels.
+				 * Past every separator on the path means the root.
+				 */
+				int lvl;
+				for (lvl = mc->mc_top - 1; lvl >= 0; lvl--) {
+					MDB_page *bp = mc->mc_pg[lvl];
+					MDB_node *bn;
+					if ((unsigned)mc->mc_ki[lvl] + 1 >= NUMKEYS(bp))
+						continue;
+					bn = NODEPTR(bp, mc->mc_ki[lvl] + 1);
+					nodekey.mv_size = NODEKSZ(bn);
+					nodekey.mv_data = NODEKEY(bn);
+					if (mc->mc_dbx->md_cmp(key, &nodekey) < 0)
+						break;
+				}
+				mc->mc_top = lvl + 1;
+				mc->mc_snum = mc->mc_top + 1;
+				rc = mdb_page_search_root(mc, key, 0);
+				if (rc != MDB_SUCCESS)
+					return rc;
+				mp = mc->mc_pg[mc->mc_top];
+				goto set2;
+			}
 		}
 		if (!mc->mc_top) {
 			/* There are no other pages */
@@ -7557,6 +8962,7 @@ mdb_xcursor_init0(MDB_cursor *mc)
 	mx->mx_dbx.md_name.mv_size = 0;
 	mx->mx_dbx.md_name.mv_data = NULL;
 	mx->mx_dbx.md_cmp = mc->mc_dbx->md_dcmp;
+	mx->mx_dbx.md_search = mdb_cmp_search(mx->mx_dbx.md_cmp);
 	mx->mx_dbx.md_dcmp = NULL;
 	mx->mx_dbx.md_rel = mc->mc_dbx->md_rel;
 }
@@ -7604,8 +9010,10 @@ mdb_xcursor_init1(MDB_cursor *mc, MDB_node *node)
 		mx->mx_db.md_root));
 	mx->mx_dbflag = DB_VALID|DB_USRVALID|DB_DUPDATA;
 #if UINT_MAX < SIZE_MAX
-	if (mx->mx_dbx.md_cmp == mdb_cmp_int && mx->mx_db.md_pad == sizeof(size_t))
+	if (mx->mx_dbx.md_cmp == mdb_cmp_int && mx->mx_db.md_pad == sizeof(size_t)) {
 		mx->mx_dbx.md_cmp = mdb_cmp_clong;
+		mx->mx_dbx.md_search = mdb_cmp_search(mdb_cmp_clong);
+	}
 #endif
 }
 
@@ -7631,6 +9039,7 @@ mdb_xcursor_init2(MDB_cursor *mc, MDB_xcursor *src_mx, int new_dupdata)
 		mx->mx_dbflag = DB_VALID|DB_USRVALID|DB_DUPDATA;
 #if UINT_MAX < SIZE_MAX
 		mx->mx_dbx.md_cmp = src_mx->mx_dbx.md_cmp;
+		mx->mx_dbx.md_search = src_mx->mx_dbx.md_search;
 #endif
 	} else if (!(mx->mx_cursor.mc_flags & C_INITIALIZED)) {
 		return;
@@ -7657,6 +9066,7 @@ mdb_cursor_init(MDB_cursor *mc, MDB_txn *txn, MDB_dbi dbi, MDB_xcursor *mx)
 	mc->mc_pg[0] = 0;
 	mc->mc_ki[0] = 0;
 	mc->mc_flags = 0;
+	mc->mc_ra_pgno = P_INVALID;
 	if (txn->mt_dbs[dbi].md_flags & MDB_DUPSORT) {
 		mdb_tassert(txn, mx != NULL);
 		mc->mc_xcursor = mx;
@@ -7758,6 +9168,107 @@ mdb_cursor_count(MDB_cursor *mc, size_t *countp)
 	return MDB_SUCCESS;
 }
 
+/** Advise the map pages \b pgno .. \b pgno + \b count - 1 with MADV_WILLNEED */
+static void
+mdb_pages_willneed(MDB_env *env, pgno_t pgno, size_t count)
+{
+#ifndef _WIN32
+	char *addr = env->me_map + (size_t)env->me_psize * pgno;
+	size_t len = (size_t)env->me_psize * count, off;
+
+	if (addr + len > env->me_map + env->me_mapsize)
+		return;
+	off = (addr - env->me_map) & (env->me_os_psize - 1);
+#ifdef MADV_WILLNEED
+	madvise(addr - off, len + off, MADV_WILLNEED);
+#elif defined(POSIX_MADV_WILLNEED)
+	posix_madvise(addr - off, len + off, POSIX_MADV_WILLNEED);
+#endif
+#endif
+}
+
+int
+mdb_cursor_readahead(MDB_cursor *mc, unsigned int pages, unsigned int flags)
+{
+	MDB_page *pp;
+	int ki, nkeys, lo, hi, same, i, run;
+	pgno_t start, pgno;
+
+	if (mc == NULL)
+		return EINVAL;
+	if (mc->mc_txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+	if (!(mc->mc_flags & C_INITIALIZED) || mc->mc_top == 0 || !pages)
+		return MDB_SUCCESS;
+
+	/* The leaves ahead of the cursor are its parent's other children */
+	pp = mc->mc_pg[mc->mc_top - 1];
+	ki = mc->mc_ki[mc->mc_top - 1];
+	nkeys = NUMKEYS(pp);
+	same = mc->mc_ra_pgno == pp->mp_pgno;
+	if (flags & MDB_READAHEAD_PREV) {
+		/* Wait until half the window has been consumed */
+		if (same && ki > mc->mc_ra_lo + (int)pages / 2)
+			return MDB_SUCCESS;
+		lo = ki > (int)pages ? ki - (int)pages : 0;
+		hi = same && mc->mc_ra_lo <= ki ? mc->mc_ra_lo - 1 : ki - 1;
+	} else {
+		if (same && ki + (int)pages / 2 < mc->mc_ra_hi)
+			return MDB_SUCCESS;
+		lo = same && mc->mc_ra_hi >= ki ? mc->mc_ra_hi + 1 : ki + 1;
+		hi = ki + (int)pages < nkeys ? ki + (int)pages : nkeys - 1;
+	}
+
+	/* One madvise per run of consecutive page numbers */
+	for (i = lo; i <= hi; i += run) {
+		start = NODEPGNO(NODEPTR(pp, i));
+		for (run = 1; i + run <= hi; run++) {
+			pgno = NODEPGNO(NODEPTR(pp, i + run));
+			if (pgno != start + run)
+				break;
+		}
+		mdb_pages_willneed(mc->mc_txn->mt_env, start, run);
+	}
+
+	if (!same) {
+		mc->mc_ra_pgno = pp->mp_pgno;
+		mc->mc_ra_lo = mc->mc_ra_hi = ki;
+	}
+	if (lo < mc->mc_ra_lo)
+		mc->mc_ra_lo = lo;
+	if (hi > mc->mc_ra_hi)
+		mc->mc_ra_hi = hi;
+	return MDB_SUCCESS;
+}
+
+int
+mdb_cursor_leaf_key(MDB_cursor *mc, MDB_val *key, MDB_cursor_op op)
+{
+	MDB_page *mp;
+	MDB_node *node;
+	indx_t i;
+
+	if (mc == NULL || key == NULL || (op != MDB_FIRST && op != MDB_LAST))
+		return EINVAL;
+	if (mc->mc_txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+	if (!(mc->mc_flags & C_INITIALIZED) || !mc->mc_snum)
+		return EINVAL;
+
+	mp = mc->mc_pg[mc->mc_top];
+	if (!NUMKEYS(mp))
+		return MDB_NOTFOUND;
+	i = op == MDB_LAST ? NUMKEYS(mp) - 1 : 0;
+	if (IS_LEAF2(mp)) {
+		key->mv_size = mc->mc_db->md_pad;
+		key->mv_data = LEAF2KEY(mp, i, key->mv_size);
+	} else {
+		node = NODEPTR(mp, i);
+		MDB_GET_KEY(node, key);
+	}
+	return MDB_SUCCESS;
+}
+
 void
 mdb_cursor_close(MDB_cursor *mc)
 {
@@ -8627,6 +10138,22 @@ mdb_del0(MDB_txn *txn, MDB_dbi dbi,
 	return rc;
 }
 
+/** Shorten a separator key for #MDB_SHORTSEP.
+ *	Cuts \b sep down to its shortest prefix that still sorts after
+ *	\b lkey by #mdb_cmp_memn. \b sep must sort after \b lkey.
+ */
+static void
+mdb_shortest_sep(MDB_val *sep, const MDB_val *lkey)
+{
+	const unsigned char *s = sep->mv_data, *l = lkey->mv_data;
+	size_t i, len = sep->mv_size < lkey->mv_size ? sep->mv_size : lkey->mv_size;
+
+	for (i = 0; i < len && s[i] == l[i]; i++)
+		;
+	if (i + 1 < sep->mv_size)
+		sep->mv_size = i + 1;
+}
+
 /** Split a page and insert a new node.
  * Set #MDB_TXN_ERROR on failure.
  * @param[in,out] mc Cursor pointing to the page and desired insertion index.
@@ -8848,6 +10375,32 @@ mdb_page_split(MDB_cursor *mc, MDB_val *newkey, MDB_val *newdata, pgno_t newpgno
 		}
 	}
 
+	/* With #MDB_SHORTSEP only as much of the right page's first key
+	 * as is needed to sort after the left page's last key goes up.
+	 */
+	if ((mc->mc_db->md_flags & MDB_SHORTSEP) && IS_LEAF(mp) && !IS_LEAF2(mp) &&
+		!(mc->mc_flags & C_SUB) && mc->mc_dbx->md_cmp == mdb_cmp_memn) {
+		MDB_val lkey;
+		lkey.mv_data = NULL;
+		if (nflags & MDB_APPEND) {
+			if (NUMKEYS(mp)) {
+				node = NODEPTR(mp, NUMKEYS(mp) - 1);
+				lkey.mv_size = NODEKSZ(node);
+				lkey.mv_data = NODEKEY(node);
+			}
+		} else if (split_indx > 0) {
+			if (split_indx - 1 == newindx) {
+				lkey = *newkey;
+			} else {
+				node = (MDB_node *)((char *)mp + copy->mp_ptrs[split_indx - 1] + PAGEBASE);
+				lkey.mv_size = NODEKSZ(node);
+				lkey.mv_data = NODEKEY(node);
+			}
+		}
+		if (lkey.mv_data)
+			mdb_shortest_sep(&sepkey, &lkey);
+	}
+
 	DPRINTF(("separator is %d [%s]", split_indx, DKEY(&sepkey)));
 
 	/* Copy separator key to the parent.
@@ -9673,6 +11226,53 @@ mdb_env_get_userctx(MDB_env *env)
 	return env ? env->me_userctx : NULL;
 }
 
+int ESECT
+mdb_env_set_uring(MDB_env *env, unsigned int depth)
+{
+#if MDB_USE_IO_URING
+	MDB_uring *ur = NULL;
+	int rc;
+
+	if (!env || env->me_txn)
+		return EINVAL;
+	if (depth && (rc = mdb_uring_create(depth, &ur)))
+		return rc;
+	mdb_uring_free(env->me_uring);
+	env->me_uring = ur;
+	return MDB_SUCCESS;
+#else
+	return (env && depth) ? ENOSYS : MDB_SUCCESS;
+#endif
+}
+
+int ESECT
+mdb_env_set_dirty_max(MDB_env *env, size_t pages)
+{
+	if (!env || env->me_txn)
+		return EINVAL;
+	if (!pages)
+		pages = MDB_IDL_UM_MAX;
+	if (pages < MDB_IDL_UM_MAX || pages > (1U << 30))
+		return EINVAL;
+	env->me_dirty_max = pages;
+	return MDB_SUCCESS;
+}
+
+int
+mdb_txn_dirty_stat(MDB_txn *txn, MDB_dirty_stat *stat)
+{
+	if (!txn || !stat || (txn->mt_flags & MDB_TXN_RDONLY))
+		return EINVAL;
+	stat->ds_dirty = txn->mt_u.dirty_list[0].mid;
+	stat->ds_peak = txn->mt_dirty_peak;
+	stat->ds_room = txn->mt_dirty_room;
+	stat->ds_max = txn->mt_parent ? MDB_IDL_UM_MAX : txn->mt_env->me_dirty_max;
+	stat->ds_spills = txn->mt_spills;
+	stat->ds_spilled = txn->mt_spilled;
+	stat->ds_unspilled = txn->mt_unspilled;
+	return MDB_SUCCESS;
+}
+
 int ESECT
 mdb_env_set_assert(MDB_env *env, MDB_assert_func *func)
 {
@@ -9770,6 +11370,7 @@ mdb_default_cmp(MDB_txn *txn, MDB_dbi dbi)
 	txn->mt_dbxs[dbi].md_cmp =
 		(f & MDB_REVERSEKEY) ? mdb_cmp_memnr :
 		(f & MDB_INTEGERKEY) ? mdb_cmp_cint  : mdb_cmp_memn;
+	txn->mt_dbxs[dbi].md_search = mdb_cmp_search(txn->mt_dbxs[dbi].md_cmp);
 
 	txn->mt_dbxs[dbi].md_dcmp =
 		!(f & MDB_DUPSORT) ? 0 :
@@ -9940,6 +11541,203 @@ int mdb_dbi_flags(MDB_txn *txn, MDB_dbi dbi, unsigned int *flags)
 	return MDB_SUCCESS;
 }
 
+/** Ask the OS to read in, and optionally lock, one page of the map */
+static int
+mdb_page_warm(MDB_env *env, MDB_page *mp, unsigned int flags)
+{
+	char *addr = (char *)mp;
+	int rc = MDB_SUCCESS;
+
+	if (addr < env->me_map || addr >= env->me_map + env->me_mapsize)
+		return MDB_SUCCESS;	/* dirty page of a write txn */
+#ifndef _WIN32
+	addr -= (addr - env->me_map) & (env->me_os_psize - 1);
+	if (flags & MDB_WARMUP_LOCK) {
+		if (mlock(addr, env->me_psize))
+			rc = ErrCode();
+	} else {
+#ifdef MADV_WILLNEED
+		madvise(addr, env->me_psize, MADV_WILLNEED);
+#elif defined(POSIX_MADV_WILLNEED)
+		posix_madvise(addr, env->me_psize, POSIX_MADV_WILLNEED);
+#endif
+	}
+#endif
+	return rc;
+}
+
+int ESECT
+mdb_dbi_warmup(MDB_txn *txn, MDB_dbi dbi, unsigned int flags, size_t *pages)
+{
+	MDB_cursor mc;
+	MDB_xcursor mx;
+	MDB_page *mp;
+	MDB_db *db;
+	pgno_t *level, *next, *tmp;
+	size_t nlevel, nnext, cap, i, count = 0;
+	unsigned int k;
+	int lvl;
+	int rc, lock_rc = MDB_SUCCESS;
+
+	if (pages)
+		*pages = 0;
+	if (!TXN_DBI_EXIST(txn, dbi, DB_USRVALID))
+		return EINVAL;
+	if (txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+
+	/* Reads the root if the DB is stale */
+	mdb_cursor_init(&mc, txn, dbi, &mx);
+	db = &txn->mt_dbs[dbi];
+	if (db->md_root == P_INVALID || db->md_depth < 2)
+		return MDB_SUCCESS;
+
+	/* No level holds more branch pages than the whole tree */
+	cap = db->md_branch_pages;
+	level = malloc(cap * sizeof(pgno_t));
+	next = malloc(cap * sizeof(pgno_t));
+	if (!level || !next) {
+		rc = ENOMEM;
+		goto done;
+	}
+	level[0] = db->md_root;
+	nlevel = 1;
+	for (lvl = 0; lvl < db->md_depth - 1; lvl++) {
+		/* Advise the whole level first so its reads overlap */
+		for (i = 0; i < nlevel; i++) {
+			if ((rc = mdb_page_get(&mc, level[i], &mp, NULL)))
+				goto done;
+			if (!(flags & MDB_WARMUP_LOCK))
+				mdb_page_warm(txn->mt_env, mp, 0);
+		}
+		nnext = 0;
+		for (i = 0; i < nlevel; i++) {
+			if ((rc = mdb_page_get(&mc, level[i], &mp, NULL)))
+				goto done;
+			if (!IS_BRANCH(mp)) {
+				rc = MDB_CORRUPTED;
+				goto done;
+			}
+			if (flags & MDB_WARMUP_LOCK) {
+				if ((rc = mdb_page_warm(txn->mt_env, mp, flags)))
+					lock_rc = rc;
+			}
+			count++;
+			/* Children of the last branch level are leaves */
+			if (lvl + 2 < db->md_depth) {
+				if (nnext + NUMKEYS(mp) > cap) {
+					rc = MDB_CORRUPTED;
+					goto done;
+				}
+				for (k = 0; k < NUMKEYS(mp); k++)
+					next[nnext++] = NODEPGNO(NODEPTR(mp, k));
+			}
+		}
+		tmp = level;
+		level = next;
+		next = tmp;
+		nlevel = nnext;
+	}
+	rc = lock_rc;
+
+done:
+	free(level);
+	free(next);
+	if (pages)
+		*pages = count;
+	return rc;
+}
+
+int ESECT
+mdb_dbi_split(MDB_txn *txn, MDB_dbi dbi, unsigned int parts,
+	MDB_val *keys, unsigned int *count)
+{
+	MDB_cursor mc;
+	MDB_xcursor mx;
+	MDB_page *mp = NULL;
+	MDB_node *node;
+	MDB_db *db;
+	pgno_t *level, *next;
+	size_t nlevel, nnodes, i, k;
+	unsigned int j, n = 0;
+	int rc = MDB_SUCCESS;
+
+	if (count)
+		*count = 0;
+	if (!keys || !count || !TXN_DBI_EXIST(txn, dbi, DB_USRVALID))
+		return EINVAL;
+	if (txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+	if (parts < 2)
+		return MDB_SUCCESS;
+
+	/* Reads the root if the DB is stale */
+	mdb_cursor_init(&mc, txn, dbi, &mx);
+	db = &txn->mt_dbs[dbi];
+	if (db->md_root == P_INVALID)
+		return MDB_SUCCESS;
+
+	level = malloc(sizeof(pgno_t));
+	if (!level)
+		return ENOMEM;
+	level[0] = db->md_root;
+	nlevel = 1;
+	/* Go down until a level has enough nodes, or the leaves are reached */
+	for (;;) {
+		nnodes = 0;
+		for (i = 0; i < nlevel; i++) {
+			if ((rc = mdb_page_get(&mc, level[i], &mp, NULL)))
+				goto done;
+			nnodes += NUMKEYS(mp);
+		}
+		if (nnodes >= parts || !IS_BRANCH(mp))
+			break;
+		if (!(next = malloc(nnodes * sizeof(pgno_t)))) {
+			rc = ENOMEM;
+			goto done;
+		}
+		for (i = 0, k = 0; i < nlevel; i++) {
+			if ((rc = mdb_page_get(&mc, level[i], &mp, NULL))) {
+				free(next);
+				goto done;
+			}
+			for (j = 0; j < NUMKEYS(mp); j++)
+				next[k++] = NODEPGNO(NODEPTR(mp, j));
+		}
+		free(level);
+		level = next;
+		nlevel = nnodes;
+	}
+
+	/* Cut before node nnodes*p/parts for p = 1..parts-1. The first node
+	 * of a branch page has no key of its own, such a cut moves right.
+	 */
+	for (i = 0, k = 0; i < nlevel && n < parts - 1; i++) {
+		if ((rc = mdb_page_get(&mc, level[i], &mp, NULL)))
+			goto done;
+		for (j = 0; j < NUMKEYS(mp) && n < parts - 1; j++, k++) {
+			if (k * parts < nnodes * (n + 1))
+				continue;
+			if (j == 0 && IS_BRANCH(mp))
+				continue;
+			if (IS_LEAF2(mp)) {
+				keys[n].mv_size = db->md_pad;
+				keys[n].mv_data = LEAF2KEY(mp, j, keys[n].mv_size);
+			} else {
+				node = NODEPTR(mp, j);
+				keys[n].mv_size = NODEKSZ(node);
+				keys[n].mv_data = NODEKEY(node);
+			}
+			n++;
+		}
+	}
+	*count = n;
+
+done:
+	free(level);
+	return rc;
+}
+
 /** Add all the DB's pages to the free list.
  * @param[in] mc Cursor on the DB to free.
  * @param[in] subs non-Zero to check for sub-DBs in this DB.
@@ -10096,6 +11894,7 @@ int mdb_set_compare(MDB_txn *txn, MDB_dbi dbi, MDB_cmp_func *cmp)
 		return EINVAL;
 
 	txn->mt_dbxs[dbi].md_cmp = cmp;
+	txn->mt_dbxs[dbi].md_search = mdb_search_generic;
 	return MDB_SUCCESS;
 }
 
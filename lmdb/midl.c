@@ -344,6 +344,18 @@ int mdb_mid2l_insert( MDB_ID2L ids, MDB_ID2 *id )
 	return 0;
 }
 
+static int mdb_mid2l_cmp( const void *a, const void *b )
+{
+	MDB_ID x = ((const MDB_ID2 *)a)->mid, y = ((const MDB_ID2 *)b)->mid;
+	return x < y ? -1 : x > y;
+}
+
+void mdb_mid2l_sort( MDB_ID2L ids )
+{
+	if ( ids[0].mid > 1 )
+		qsort( ids + 1, ids[0].mid, sizeof(MDB_ID2), mdb_mid2l_cmp );
+}
+
 int mdb_mid2l_append( MDB_ID2L ids, MDB_ID2 *id )
 {
 	/* Too big? */
@@ -178,6 +178,11 @@ int mdb_mid2l_insert( MDB_ID2L ids, MDB_ID2 *id );
 	 */
 int mdb_mid2l_append( MDB_ID2L ids, MDB_ID2 *id );
 
+	/** Sort an ID2L built with #mdb_mid2l_append(), in ascending ID order.
+	 * @param[in,out] ids	The ID2L to sort.
+	 */
+void mdb_mid2l_sort( MDB_ID2L ids );
+
 /** @} */
 /** @} */
 #ifdef __cplusplus
@@ -5,8 +5,31 @@
 #include <iostream>
 #include <iomanip>
 #include <random>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <fstream>
+#include <cmath>
+#include <charconv>
+#include <type_traits>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <optional>
+#include <span>
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#include <latch>
+#endif
 #include <assert.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <gflags/gflags.h>
 #include <omp.h>
 #include "lmdb.h"
@@ -91,32 +114,235 @@ inline bool operator==(const Slice& x, const Slice& y) {
 
 inline bool operator!=(const Slice& x, const Slice& y) { return !(x == y); }
 
+// builds keys in an inline buffer without touching the heap, the returned Slice points into
+// the encoder and is valid until the next clear()/append. fixed width encodings are big endian
+// (sign bit flipped for signed types) so memcmp order matches numeric order.
+template <size_t N = 64>
+class KeyEncoder {
+    char buf_[N];
+    size_t size_ = 0;
+
+    template <typename T>
+    KeyEncoder &append_be(T value) {
+        assert(size_ + sizeof(T) <= N);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            buf_[size_ + i] = (char) (value >> (8 * (sizeof(T) - 1 - i)));
+        }
+        size_ += sizeof(T);
+        return *this;
+    }
+
+public:
+    KeyEncoder &clear() {
+        size_ = 0;
+        return *this;
+    }
+
+    // same bytes as std::to_string
+    template <typename T>
+    KeyEncoder &append_decimal(T value) {
+        auto res = std::to_chars(buf_ + size_, buf_ + N, value);
+        assert(res.ec == std::errc());
+        size_ = res.ptr - buf_;
+        return *this;
+    }
+
+    KeyEncoder &append_fixed32(uint32_t value) { return append_be(value); }
+
+    KeyEncoder &append_fixed64(uint64_t value) { return append_be(value); }
+
+    KeyEncoder &append_fixed32(int32_t value) { return append_be((uint32_t) value ^ 0x80000000u); }
+
+    KeyEncoder &append_fixed64(int64_t value) { return append_be((uint64_t) value ^ 0x8000000000000000ull); }
+
+    KeyEncoder &append(const Slice &s) {
+        assert(size_ + s.size() <= N);
+        memcpy(buf_ + size_, s.data(), s.size());
+        size_ += s.size();
+        return *this;
+    }
+
+    KeyEncoder &append(char c) {
+        assert(size_ < N);
+        buf_[size_++] = c;
+        return *this;
+    }
+
+    Slice slice() const { return Slice(buf_, size_); }
+
+    static uint32_t decode_fixed32(const char *p) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < sizeof(value); ++i) {
+            value = (value << 8) | (unsigned char) p[i];
+        }
+        return value;
+    }
+
+    static uint64_t decode_fixed64(const char *p) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(value); ++i) {
+            value = (value << 8) | (unsigned char) p[i];
+        }
+        return value;
+    }
+};
+
 class DBEnv;
 class DBInstance;
+class Iterator;
+// move-only, aborts on scope exit unless committed
 class Transaction {
     MDB_txn *txn_ = nullptr;
+    // iterators opened in a write txn, lmdb frees their cursors when the txn ends
+    Iterator *cursors_ = nullptr;
+    bool read_only_ = false;
+    // env whose resize gate this txn holds, see DBEnv::set_map_growth
+    DBEnv *gate_ = nullptr;
     friend class DBEnv;
     friend class DBInstance;
+    friend class Iterator;
+    friend class WriteCoordinator;
+
+    inline void rebind_cursors();
+
+    inline void detach_cursors();
+
+    inline void leave_gate();
 
 public:
-    ~Transaction(){
+    Transaction() = default;
+
+    Transaction(Transaction &&other) noexcept
+            : txn_(other.txn_), cursors_(other.cursors_), read_only_(other.read_only_), gate_(other.gate_) {
+        other.txn_ = nullptr;
+        other.cursors_ = nullptr;
+        other.gate_ = nullptr;
+        rebind_cursors();
+    }
+
+    Transaction &operator=(Transaction &&other) noexcept {
+        if (this != &other) {
+            abort();
+            txn_ = other.txn_;
+            cursors_ = other.cursors_;
+            read_only_ = other.read_only_;
+            gate_ = other.gate_;
+            other.txn_ = nullptr;
+            other.cursors_ = nullptr;
+            other.gate_ = nullptr;
+            rebind_cursors();
+        }
+        return *this;
+    }
+
+    Transaction(const Transaction &) = delete;
 
+    Transaction &operator=(const Transaction &) = delete;
+
+    ~Transaction(){
+        abort();
     }
+
     int commit(){
-        return mdb_txn_commit(txn_);
+        detach_cursors();
+        int ret = mdb_txn_commit(txn_);
+        txn_ = nullptr;
+        leave_gate();
+        return ret;
     }
+
     void abort(){
-        mdb_txn_abort(txn_);
+        if (txn_) {
+            detach_cursors();
+            mdb_txn_abort(txn_);
+            txn_ = nullptr;
+            leave_gate();
+        }
+    }
+
+    explicit operator bool() const {
+        return txn_ != nullptr;
+    }
+    void reset(){
+        mdb_txn_reset(txn_);
+        leave_gate();
+    }
+    inline int renew();
+
+    // dirty page and spill counters of a write txn, see DBEnv::set_dirty_max
+    int dirty_stat(MDB_dirty_stat &out_stat) {
+        return mdb_txn_dirty_stat(txn_, &out_stat);
     }
 };
 
+// move-only cursor handle. in a write txn it is linked into the txn and detached
+// when the txn ends; in a read txn it outlives the txn and can be moved onto
+// another one with renew()
 class Iterator {
     MDB_cursor *cursor_ = nullptr;
     MDB_val key_, data_;
     bool valid_ = false;
+    unsigned int readahead_ = 0;
+    Transaction *owner_ = nullptr;
+    Iterator *prev_ = nullptr;
+    Iterator *next_ = nullptr;
     friend class DBEnv;
-
+    friend class Transaction;
     friend class DBInstance;
+    friend class RangeIterator;
+
+    void link(Transaction *owner) {
+        owner_ = owner;
+        next_ = owner->cursors_;
+        if (next_) {
+            next_->prev_ = this;
+        }
+        owner->cursors_ = this;
+    }
+
+    void unlink() {
+        if (prev_) {
+            prev_->next_ = next_;
+        } else {
+            owner_->cursors_ = next_;
+        }
+        if (next_) {
+            next_->prev_ = prev_;
+        }
+        owner_ = nullptr;
+        prev_ = next_ = nullptr;
+    }
+
+    // the object moved, point the neighbours and the txn at the new address
+    void relink() {
+        if (!owner_) {
+            return;
+        }
+        if (prev_) {
+            prev_->next_ = this;
+        } else {
+            owner_->cursors_ = this;
+        }
+        if (next_) {
+            next_->prev_ = this;
+        }
+    }
+
+    void take(Iterator &other) {
+        cursor_ = other.cursor_;
+        key_ = other.key_;
+        data_ = other.data_;
+        valid_ = other.valid_;
+        readahead_ = other.readahead_;
+        owner_ = other.owner_;
+        prev_ = other.prev_;
+        next_ = other.next_;
+        other.cursor_ = nullptr;
+        other.valid_ = false;
+        other.owner_ = nullptr;
+        other.prev_ = other.next_ = nullptr;
+        relink();
+    }
 
 public:
     enum class NextType {
@@ -137,16 +363,61 @@ public:
         Last = MDB_LAST,
         Dup = MDB_LAST_DUP,
     };
+    Iterator() = default;
+
+    Iterator(Iterator &&other) noexcept {
+        take(other);
+    }
+
+    Iterator &operator=(Iterator &&other) noexcept {
+        if (this != &other) {
+            close();
+            take(other);
+        }
+        return *this;
+    }
+
+    Iterator(const Iterator &) = delete;
+
+    Iterator &operator=(const Iterator &) = delete;
+
     ~Iterator() {
+        close();
+    }
+
+    void close() {
+        if (owner_) {
+            unlink();
+        }
         mdb_cursor_close(cursor_);
+        cursor_ = nullptr;
+        valid_ = false;
+    }
+
+    // rebind a read-only cursor to another (or a renewed) read txn of the same env
+    int renew(Transaction &txn) {
+        valid_ = false;
+        return mdb_cursor_renew(txn.txn_, cursor_);
+    }
+
+    // sequential scan hint: keep the next `pages` leaf pages advised while stepping,
+    // 0 leaves readahead to the env policy
+    void set_readahead(unsigned int pages) {
+        readahead_ = pages;
     }
 
     void next(NextType nt = NextType::Next) {
         valid_ = ( mdb_cursor_get(cursor_, &key_, &data_, (MDB_cursor_op)nt) == MDB_SUCCESS);
+        if (readahead_ && valid_) {
+            mdb_cursor_readahead(cursor_, readahead_, 0);
+        }
     }
 
     void prev(PrevType pt = PrevType::Prev) {
         valid_ = ( mdb_cursor_get(cursor_, &key_, &data_, (MDB_cursor_op)pt) == MDB_SUCCESS);
+        if (readahead_ && valid_) {
+            mdb_cursor_readahead(cursor_, readahead_, MDB_READAHEAD_PREV);
+        }
     }
 
     void seek_last(LastType lt = LastType::Last) {
@@ -164,6 +435,11 @@ public:
         key_ = key.to_mdb_val();
         return mdb_cursor_get(cursor_, &key_, &data_, MDB_SET_KEY) == MDB_SUCCESS;
     }
+    bool get_both(Slice key, Slice value){
+        key_ = key.to_mdb_val();
+        data_ = value.to_mdb_val();
+        return mdb_cursor_get(cursor_, &key_, &data_, MDB_GET_BOTH) == MDB_SUCCESS;
+    }
     void seek_to(Slice key){
         key_ = key.to_mdb_val();
         valid_ = (mdb_cursor_get(cursor_, &key_, &data_, MDB_SET_RANGE) == MDB_SUCCESS);
@@ -181,245 +457,3318 @@ public:
     }
 };
 
-class DBEnv {
-    MDB_env *env_ = nullptr;
-
-    friend class DBInstance;
-public:
-    DBEnv(const string& path, std::size_t size,unsigned int flag = (MDB_FIXEDMAP|MDB_NOSYNC)){
-        CHECK_MDB(mdb_env_create(&env_));
-        CHECK_MDB(mdb_env_set_maxreaders(env_, 100));
-        CHECK_MDB(mdb_env_set_mapsize(env_, size));
-        CHECK_MDB(mdb_env_set_maxdbs(env_, 40));
-        CHECK_MDB(mdb_env_open(env_, path.data(), flag, 0664));
+inline void Transaction::rebind_cursors() {
+    for (auto iter = cursors_; iter; iter = iter->next_) {
+        iter->owner_ = this;
     }
-    ~DBEnv(){
-        mdb_env_close(env_);
+}
+
+inline void Transaction::detach_cursors() {
+    while (cursors_) {
+        auto iter = cursors_;
+        iter->unlink();
+        iter->cursor_ = nullptr;
+        iter->valid_ = false;
     }
+}
 
-    shared_ptr<Transaction> new_transaction(unsigned int flags = 0) {
-        auto txn = make_shared<Transaction>();
-        CHECK_MDB(mdb_txn_begin(env_, NULL, flags, &txn->txn_));
-        return txn;
+// key range of a RangeIterator, in the key order of the db. a missing bound leaves that
+// side open, limit 0 returns every record
+struct KeyRange {
+    std::optional<string> lower, upper;
+    bool lower_inclusive = true;
+    bool upper_inclusive = false;
+    size_t limit = 0;
+    bool reverse = false;
+
+    // smallest key after every key starting with prefix in memcmp order: trailing 0xff
+    // bytes dropped and the last byte left incremented. none if nothing is left
+    static std::optional<string> prefix_successor(Slice prefix) {
+        string out = prefix.to_string();
+        while (!out.empty() && (unsigned char) out.back() == 0xff) {
+            out.pop_back();
+        }
+        if (out.empty()) {
+            return std::nullopt;
+        }
+        out.back() = (char) ((unsigned char) out.back() + 1);
+        return out;
     }
 
+    // keys starting with prefix, for memcmp ordered dbs
+    static KeyRange prefix(Slice prefix) {
+        KeyRange range;
+        range.lower = prefix.to_string();
+        range.upper = prefix_successor(prefix);
+        return range;
+    }
 };
 
-class DBInstance{
-    MDB_dbi dbi_ = 0;
-public:
-    DBInstance() = default;
-    int init(Transaction &txn, const string& db_name,unsigned int flag = MDB_CREATE){
-        return mdb_dbi_open(txn.txn_, db_name.data(), flag, &dbi_);
-    }
-    void close(DBEnv& env){
-        mdb_dbi_close(env.env_, dbi_);
-    }
+// walks a KeyRange on one cursor, forward from the lower bound or backward from the upper.
+// the end bound is compared with the edge key of each leaf page (mdb_cursor_leaf_key), the
+// records of a page that lies inside the range are returned without comparing them
+class RangeIterator {
+    Iterator iter_;
+    KeyRange range_;
+    bool dupsort_ = false;
+    bool valid_ = false;
+    size_t count_ = 0;
+    // last key of the current leaf page, the first one when going backward
+    const void *edge_ = nullptr;
+    bool at_edge_ = false;
+    bool page_inside_ = false;
+    friend class DBInstance;
 
-    int write(Transaction &txn, Slice key, Slice value, unsigned flag = MDB_NOOVERWRITE) {
-        MDB_val tmp_key = key.to_mdb_val();
-        MDB_val tmp_data = value.to_mdb_val();
-        return mdb_put(txn.txn_, dbi_, &tmp_key, &tmp_data, flag);
+    RangeIterator(Iterator &&iter, KeyRange range) : iter_(std::move(iter)), range_(std::move(range)) {
+        unsigned int flags = 0;
+        if (iter_.cursor_ &&
+            mdb_dbi_flags(mdb_cursor_txn(iter_.cursor_), mdb_cursor_dbi(iter_.cursor_), &flags) == MDB_SUCCESS) {
+            dupsort_ = flags & MDB_DUPSORT;
+        }
     }
 
-    shared_ptr<Iterator> new_iterator(Transaction &txn) {
-        auto iter = make_shared<Iterator>();
-        mdb_cursor_open(txn.txn_, dbi_, &iter->cursor_);
-        return iter;
+    int compare(Slice a, const string &b) {
+        MDB_val tmp_a = a.to_mdb_val();
+        MDB_val tmp_b = Slice(b).to_mdb_val();
+        return mdb_cmp(mdb_cursor_txn(iter_.cursor_), mdb_cursor_dbi(iter_.cursor_), &tmp_a, &tmp_b);
     }
 
-    int del(Transaction &txn, Slice &key) {
-        MDB_val tmp_key, tmp_data;
-        tmp_key = key.to_mdb_val();
-        return mdb_del(txn.txn_, dbi_, &tmp_key, &tmp_data);
+    // key lies beyond the bound the scan is heading to
+    bool past_end(Slice key) {
+        if (!range_.reverse) {
+            if (!range_.upper) {
+                return false;
+            }
+            int ret = compare(key, *range_.upper);
+            return ret > 0 || (ret == 0 && !range_.upper_inclusive);
+        }
+        if (!range_.lower) {
+            return false;
+        }
+        int ret = compare(key, *range_.lower);
+        return ret < 0 || (ret == 0 && !range_.lower_inclusive);
     }
 
-    bool get(Transaction &txn, Slice key, Slice &out_value) {
-        MDB_val tmp_value;
-        MDB_val tmp_key = key.to_mdb_val();
-        auto ret = mdb_get(txn.txn_, dbi_, &tmp_key, &tmp_value);
-        CHECK_MDB(ret);
-        if (ret == MDB_SUCCESS) {
-            out_value = tmp_value;
-            return true;
+    // after every cursor move. stepping off a page leaves its edge node, only then the
+    // new page's edge key is fetched and checked
+    void settle() {
+        valid_ = iter_.valid() && (!range_.limit || count_ < range_.limit);
+        if (!valid_) {
+            return;
+        }
+        if (range_.reverse ? range_.lower : range_.upper) {
+            const void *key = iter_.key_.mv_data;
+            if (!edge_ || (at_edge_ && key != edge_)) {
+                MDB_val edge;
+                if (mdb_cursor_leaf_key(iter_.cursor_, &edge, range_.reverse ? MDB_FIRST : MDB_LAST) == MDB_SUCCESS) {
+                    edge_ = edge.mv_data;
+                    page_inside_ = !past_end(edge);
+                } else {
+                    edge_ = nullptr;
+                    page_inside_ = false;
+                }
+            }
+            at_edge_ = key == edge_;
+            valid_ = page_inside_ || !past_end(iter_.key());
+        }
+        if (valid_) {
+            ++count_;
         }
-
-        return false;
     }
 
-};
-
-void print_stats(const char* func_name, int time_cost,size_t counter){
-    cout.setf(ios::left);
-//    std::cout << std::setw(32) <<func_name  << " timecost:" << time_cost << " μs"<<std::endl;
-    std::cout << std::setw(32) <<func_name  << " : " << counter / (double)time_cost * 1000*1000 << " op/s"<< " total:" << counter << " timecost:" << time_cost << " μs"<<std::endl;
-}
-DEFINE_string(type, "", "");
-DEFINE_string(prefix_seek, "1", "param for prefix seek");
-DEFINE_string(path, "testdb", "db path");
-DEFINE_uint64(count, 1000000, " write count");
-DEFINE_uint64(read_count, 1000000, "random read counts");
-DEFINE_uint64(db_size, 1, "db size in disk, GB");
-DEFINE_bool(print, false, "print result");
-void write_test(DBEnv& db_env){
-    auto start = std::chrono::high_resolution_clock::now();
-
-    auto txn = db_env.new_transaction();
+public:
+    RangeIterator() = default;
+
+    // position on the first record of the range, again from the start if called twice
+    void seek() {
+        count_ = 0;
+        edge_ = nullptr;
+        at_edge_ = false;
+        // lmdb rejects empty keys, nothing sorts before them
+        if (!range_.reverse) {
+            if (!range_.lower || range_.lower->empty()) {
+                iter_.seek_first();
+            } else {
+                iter_.seek_to(*range_.lower);
+                if (iter_.valid() && !range_.lower_inclusive && compare(iter_.key(), *range_.lower) == 0) {
+                    iter_.next(Iterator::NextType::NoDup);
+                }
+            }
+        } else if (!range_.upper) {
+            iter_.seek_last();
+        } else if (range_.upper->empty()) {
+            iter_.valid_ = false;
+        } else {
+            iter_.seek_to(*range_.upper);
+            if (!iter_.valid()) {
+                iter_.seek_last();
+            } else {
+                int ret = compare(iter_.key(), *range_.upper);
+                if (ret > 0 || (ret == 0 && !range_.upper_inclusive)) {
+                    iter_.prev();
+                } else if (dupsort_) {
+                    iter_.seek_last(Iterator::LastType::Dup);
+                }
+            }
+        }
+        settle();
+    }
 
-    DBInstance db_ins;
-    db_ins.init(*txn,"db1");
-    size_t counter = 0;
-    for(std::size_t i = 0; i < FLAGS_count; ++i){
-        auto ret = db_ins.write(*txn,to_string(i),to_string(i));
-        if(ret == 0){
-            ++counter;
+    void next() {
+        if (!valid_) {
+            return;
+        }
+        if (range_.reverse) {
+            iter_.prev();
+        } else {
+            iter_.next();
         }
+        settle();
     }
-    txn->commit();
-    auto elapsed = std::chrono::high_resolution_clock::now() - start;
-    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
-    print_stats(__FUNCTION__,time_cost,counter);
-    db_ins.close(db_env);
-}
 
-void iter_test(DBEnv& db_env){
-    auto start = std::chrono::high_resolution_clock::now();
+    void set_readahead(unsigned int pages) {
+        iter_.set_readahead(pages);
+    }
 
-    auto new_txn = db_env.new_transaction(MDB_RDONLY);
-    DBInstance db_ins;
-    db_ins.init(*new_txn,"db1");
+    void close() {
+        iter_.close();
+        valid_ = false;
+    }
 
+    Slice key() {
+        return iter_.key();
+    }
 
-    auto iter = db_ins.new_iterator(*new_txn);
-    size_t counter = 0;
-    for(iter->seek_first();iter->valid(); iter->next()){
-        ++counter;
+    Slice value() {
+        return iter_.value();
     }
-    new_txn->abort();
 
+    bool valid() {
+        return valid_;
+    }
 
-    iter.reset();
-    new_txn.reset();
+    // records returned since seek
+    size_t count() {
+        return count_;
+    }
+};
 
-    db_ins.close(db_env);
-    auto elapsed = std::chrono::high_resolution_clock::now() - start;
-    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
-    print_stats(__FUNCTION__,time_cost,counter);
-}
-void rand_read_test(DBEnv& db_env){
-    //rand read
-    auto start = std::chrono::high_resolution_clock::now();
+// read txn borrowed from the calling thread's pool in DBEnv, reset and handed back
+// to the pool of the releasing thread on destruction
+class PooledTxn {
+    DBEnv *env_ = nullptr;
+    Transaction txn_;
+    friend class DBEnv;
 
-    auto new_txn = db_env.new_transaction(MDB_RDONLY);
-    DBInstance db_ins;
-    db_ins.init(*new_txn,"db1");
+    PooledTxn(DBEnv *env, Transaction &&txn) : env_(env), txn_(std::move(txn)) {}
 
+public:
+    PooledTxn() = default;
 
-    auto iter = db_ins.new_iterator(*new_txn);
-    size_t counter = 0;
-    std::random_device rd;  // 将用于为随机数引擎获得种子
-    std::mt19937 gen(rd()); // 以播种标准 mersenne_twister_engine
-    std::uniform_int_distribution<> dis(0, FLAGS_count-1);
-    for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
-        string key = to_string(dis(gen));
-        Slice out_value;
-        if (db_ins.get(*new_txn, key, out_value)) {
-            ++counter;
+    PooledTxn(PooledTxn &&other) noexcept : env_(other.env_), txn_(std::move(other.txn_)) {}
+
+    PooledTxn &operator=(PooledTxn &&other) noexcept {
+        if (this != &other) {
+            release();
+            env_ = other.env_;
+            txn_ = std::move(other.txn_);
         }
+        return *this;
     }
-    new_txn->abort();
-
-    iter.reset();
-    new_txn.reset();
-    db_ins.close(db_env);
-    auto elapsed = std::chrono::high_resolution_clock::now() - start;
-    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
-    print_stats(__FUNCTION__,time_cost,counter);
-}
 
-int my_rand(const int & min, const int & max) {
-    static thread_local std::mt19937 generator;
-    std::uniform_int_distribution<int> distribution(min,max);
-    return distribution(generator);
-}
+    PooledTxn(const PooledTxn &) = delete;
 
-void rand_parallel_read_test(DBEnv& db_env){
-    //rand read
-    auto start = std::chrono::high_resolution_clock::now();
+    PooledTxn &operator=(const PooledTxn &) = delete;
 
-    auto new_txn = db_env.new_transaction(MDB_RDONLY);
-    DBInstance db_ins;
-    db_ins.init(*new_txn,"db1");
+    ~PooledTxn() {
+        release();
+    }
 
+    Transaction &operator*() { return txn_; }
 
-    auto iter = db_ins.new_iterator(*new_txn);
-//    size_t counter = 0;
-//    std::random_device rd;  // 将用于为随机数引擎获得种子
-//    std::mt19937 gen(rd()); // 以播种标准 mersenne_twister_engine
-//    std::uniform_int_distribution<> dis(0, FLAGS_count);
-#pragma omp parallel for
-    for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
-        string key = to_string(my_rand(0,FLAGS_count));
-        Slice out_value;
-        if (db_ins.get(*new_txn, key, out_value)) {
-            if(FLAGS_print){
-                std::cout << "get key:" << key<<" value :" <<out_value.to_string() << std::endl;
-            }
-//            ++counter;
-        }
-    }
-    new_txn->abort();
+    Transaction *operator->() { return &txn_; }
 
-    iter.reset();
-    new_txn.reset();
-    db_ins.close(db_env);
-    auto elapsed = std::chrono::high_resolution_clock::now() - start;
-    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
-    print_stats(__FUNCTION__,time_cost,FLAGS_read_count);
-}
+    explicit operator bool() const { return bool(txn_); }
 
+    inline void release();
+};
 
-void prefix_seek_test(DBEnv& db_env, const string& seek_key){
-    //cursor seek
-    auto start = std::chrono::high_resolution_clock::now();
+class DBEnv {
+    MDB_env *env_ = nullptr;
 
-    auto new_txn = db_env.new_transaction(MDB_RDONLY);
-    DBInstance db_ins;
-    db_ins.init(*new_txn,"db1");
+    // idle read txns of one thread, kept in the mdb_txn_reset state
+    struct ReadTxnPool {
+        vector<Transaction> idle;
+    };
+    static std::atomic<uint64_t> next_id_;
+    uint64_t id_ = next_id_++;
+    size_t pool_size_ = 1;
+    std::mutex pools_mutex_;
+    vector<unique_ptr<ReadTxnPool>> pools_;
 
+public:
+    // map growth on MDB_MAP_FULL, off while max_size is 0
+    struct MapGrowth {
+        size_t max_size = 0;
+        double factor = 2;
+        size_t min_step = 64 << 20;
+        // fallocate each added range, a full disk then fails the growth instead of a
+        // later page write (or a SIGBUS with MDB_WRITEMAP)
+        bool preallocate = false;
+    };
 
-    auto iter = db_ins.new_iterator(*new_txn);
-    size_t counter = 0;
+private:
+    // while growth is on every txn holds the gate from begin/renew to commit/abort/reset,
+    // a resize closes it and waits for the txns inside to end
+    MapGrowth growth_;
+    std::mutex gate_mutex_;
+    std::condition_variable gate_cv_;
+    size_t active_txns_ = 0;
+    bool resizing_ = false;
+    std::atomic<size_t> resizes_{0};
+    int advice_ = -1;
+    std::atomic<bool> locked_{false};
+
+    void enter_gate(Transaction &txn) {
+        if (!growth_.max_size) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(gate_mutex_);
+        gate_cv_.wait(lock, [&] { return !resizing_; });
+        ++active_txns_;
+        txn.gate_ = this;
+    }
 
-    for (iter->seek_to(seek_key); iter->valid() &&
-                                  iter->key().starts_with(seek_key); iter->next()) {
-        if(FLAGS_print){
-            std::cout << "value :" << iter->value().to_string_view() << std::endl;
+    void leave_gate() {
+        std::lock_guard<std::mutex> lock(gate_mutex_);
+        if (--active_txns_ == 0 && resizing_) {
+            gate_cv_.notify_all();
         }
-        ++counter;
     }
 
-    iter.reset();
-    new_txn.reset();
-    auto elapsed = std::chrono::high_resolution_clock::now() - start;
-    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    int begin_transaction(Transaction &txn, unsigned int flags) {
+        txn.read_only_ = flags & MDB_RDONLY;
+        for (;;) {
+            enter_gate(txn);
+            int ret = mdb_txn_begin(env_, NULL, flags, &txn.txn_);
+            if (ret == MDB_SUCCESS) {
+                return ret;
+            }
+            txn.txn_ = nullptr;
+            txn.leave_gate();
+            // another process grew the map past this one's, adopt its size
+            if (ret != MDB_MAP_RESIZED || !growth_.max_size || (ret = resize_map(0)) != MDB_SUCCESS) {
+                return ret;
+            }
+        }
+    }
+
+    // size 0 adopts the size recorded in the meta page. waits until no txn of this
+    // process is active, the calling thread must not hold one. a growth is skipped when
+    // the map was resized since seen_resizes, the txn that failed ran on a smaller map
+    int resize_map(size_t size, bool grow = false, size_t seen_resizes = 0) {
+        std::unique_lock<std::mutex> lock(gate_mutex_);
+        gate_cv_.wait(lock, [&] { return !resizing_; });
+        if (grow && resizes_ != seen_resizes) {
+            return MDB_SUCCESS;
+        }
+        resizing_ = true;
+        gate_cv_.wait(lock, [&] { return active_txns_ == 0; });
+        MDB_envinfo info;
+        int ret = mdb_env_info(env_, &info);
+        size_t old_size = info.me_mapsize;
+        if (ret == MDB_SUCCESS && grow) {
+            size = std::max<size_t>(size, old_size * growth_.factor);
+            size = std::min(std::max(size, old_size + growth_.min_step), growth_.max_size);
+            if (size <= old_size) {
+                ret = MDB_MAP_FULL;
+            }
+        }
+        if (ret == MDB_SUCCESS) {
+            ret = mdb_env_set_mapsize(env_, size);
+        }
+        if (ret == MDB_SUCCESS) {
+            ++resizes_;
+            CHECK_MDB(mdb_env_info(env_, &info));
+            if (advice_ >= 0) {
+                madvise(info.me_mapaddr, info.me_mapsize, advice_);
+            }
+#ifdef FALLOC_FL_KEEP_SIZE
+            mdb_filehandle_t fd;
+            if (growth_.preallocate && info.me_mapsize > old_size && mdb_env_get_fd(env_, &fd) == MDB_SUCCESS &&
+                fallocate(fd, FALLOC_FL_KEEP_SIZE, old_size, info.me_mapsize - old_size) && errno != EOPNOTSUPP) {
+                ret = errno;
+            }
+#endif
+        }
+        resizing_ = false;
+        gate_cv_.notify_all();
+        lock.unlock();
+        // the new mapping has no locked pages, lock the branch pages again
+        if (ret == MDB_SUCCESS && locked_) {
+            warmup(true);
+        }
+        return ret;
+    }
+
+    ReadTxnPool &local_pool() {
+        // DBEnv addresses can be reused, the id can not
+        thread_local vector<pair<uint64_t, ReadTxnPool *>> cache;
+        for (auto &entry : cache) {
+            if (entry.first == id_) {
+                return *entry.second;
+            }
+        }
+        std::lock_guard<std::mutex> lock(pools_mutex_);
+        pools_.emplace_back(new ReadTxnPool);
+        pools_.back()->idle.reserve(pool_size_);
+        cache.emplace_back(id_, pools_.back().get());
+        return *pools_.back();
+    }
+
+    friend class DBInstance;
+    friend class PooledTxn;
+    friend class Transaction;
+    friend class WriteCoordinator;
+public:
+    DBEnv(const string& path, std::size_t size,unsigned int flag = (MDB_FIXEDMAP|MDB_NOSYNC),
+          unsigned int max_readers = 100){
+        CHECK_MDB(mdb_env_create(&env_));
+        CHECK_MDB(mdb_env_set_maxreaders(env_, max_readers));
+        CHECK_MDB(mdb_env_set_mapsize(env_, size));
+        CHECK_MDB(mdb_env_set_maxdbs(env_, 40));
+        CHECK_MDB(mdb_env_open(env_, path.data(), flag, 0664));
+        CHECK_MDB(mdb_env_set_userctx(env_, this));
+    }
+    ~DBEnv(){
+        pools_.clear();
+        mdb_env_close(env_);
+    }
+
+    // idle read txns kept per thread, applies to threads that have not used the pool yet.
+    // without MDB_NOTLS a thread can only have one read txn open at a time, so more than
+    // one only pays off with MDB_NOTLS
+    void set_read_txn_pool_size(size_t size) {
+        pool_size_ = size;
+    }
+
+    // read txn from the calling thread's pool: mdb_txn_renew on a pooled txn instead
+    // of mdb_txn_begin, no allocation and no reader table lock once the pool is warm
+    PooledTxn read_txn() {
+        auto &pool = local_pool();
+        if (!pool.idle.empty()) {
+            Transaction txn = std::move(pool.idle.back());
+            pool.idle.pop_back();
+            if (txn.renew() == MDB_SUCCESS) {
+                return PooledTxn(this, std::move(txn));
+            }
+        }
+        return PooledTxn(this, new_transaction(MDB_RDONLY));
+    }
+
+    void release_read_txn(Transaction &&txn) {
+        auto &pool = local_pool();
+        if (pool.idle.size() < pool_size_) {
+            txn.reset();
+            pool.idle.push_back(std::move(txn));
+        } else {
+            txn.abort();
+        }
+    }
+
+    Transaction new_transaction(unsigned int flags = 0) {
+        Transaction txn;
+        CHECK_MDB(begin_transaction(txn, flags));
+        return txn;
+    }
+
+    // the env a txn was begun in
+    static DBEnv *of(MDB_txn *txn) {
+        return (DBEnv *) mdb_env_get_userctx(mdb_txn_env(txn));
+    }
+
+    // let writes that fail with MDB_MAP_FULL grow the map to max_size and replay, see
+    // write_txn. also adopts a map grown by another process (MDB_MAP_RESIZED). call it
+    // before any txn is open; a remap must not have to land at the old address, so
+    // envs opened with MDB_FIXEDMAP are refused
+    int set_map_growth(MapGrowth growth) {
+        unsigned int flags = 0;
+        int ret = mdb_env_get_flags(env_, &flags);
+        if (ret != MDB_SUCCESS) {
+            return ret;
+        }
+        if (growth.max_size && (flags & MDB_FIXEDMAP)) {
+            return EINVAL;
+        }
+        growth_ = growth;
+        return MDB_SUCCESS;
+    }
+
+    // grows the map by the growth policy once no txn is active, MDB_MAP_FULL at max_size.
+    // seen_resizes is map_resizes() while the failed txn was open, the map is only grown
+    // if no other writer grew it since
+    int grow_map(size_t seen_resizes) {
+        if (!growth_.max_size) {
+            return MDB_MAP_FULL;
+        }
+        return resize_map(0, true, seen_resizes);
+    }
+
+    size_t map_resizes() {
+        return resizes_;
+    }
+
+    size_t map_size() {
+        MDB_envinfo info;
+        CHECK_MDB(mdb_env_info(env_, &info));
+        return info.me_mapsize;
+    }
+
+    // highest page ever used, the data file does not shrink below it
+    size_t last_pgno() {
+        MDB_envinfo info;
+        CHECK_MDB(mdb_env_info(env_, &info));
+        return info.me_last_pgno;
+    }
+
+    // runs fn(txn) in a new write txn and commits it, fn returns MDB_SUCCESS or the error
+    // that aborts the txn. when fn or the commit fails with MDB_MAP_FULL the map is grown
+    // and fn runs again in a fresh txn, so fn must not keep effects outside of it
+    template <typename F>
+    int write_txn(F &&fn, unsigned int flags = 0) {
+        for (;;) {
+            Transaction txn;
+            int ret = begin_transaction(txn, flags);
+            if (ret != MDB_SUCCESS) {
+                return ret;
+            }
+            // no resize happens while the txn holds the gate
+            size_t resizes = resizes_;
+            ret = fn(txn);
+            if (ret == MDB_SUCCESS) {
+                ret = txn.commit();
+            } else {
+                txn.abort();
+            }
+            if (ret != MDB_MAP_FULL || grow_map(resizes) != MDB_SUCCESS) {
+                return ret;
+            }
+        }
+    }
+
+    // madvise/touch (or mlock) the branch pages of the main db and every named db,
+    // returns the number of pages visited. once locked, a map growth locks them again
+    size_t warmup(bool lock = false) {
+        if (lock) {
+            locked_ = true;
+        }
+        size_t total = 0;
+        Transaction new_txn = new_transaction(MDB_RDONLY);
+        MDB_txn *txn = new_txn.txn_;
+        MDB_dbi main_dbi;
+        if (mdb_dbi_open(txn, NULL, 0, &main_dbi) == MDB_SUCCESS) {
+            vector<MDB_dbi> dbis{main_dbi};
+            MDB_cursor *cursor;
+            CHECK_MDB(mdb_cursor_open(txn, main_dbi, &cursor));
+            MDB_val key, data;
+            while (mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+                string name((const char *) key.mv_data, key.mv_size);
+                MDB_dbi dbi;
+                // plain keys of the main db fail with MDB_INCOMPATIBLE
+                if (mdb_dbi_open(txn, name.c_str(), 0, &dbi) == MDB_SUCCESS) {
+                    dbis.push_back(dbi);
+                }
+            }
+            mdb_cursor_close(cursor);
+            for (auto dbi : dbis) {
+                size_t pages = 0;
+                CHECK_MDB(mdb_dbi_warmup(txn, dbi, lock ? MDB_WARMUP_LOCK : 0, &pages));
+                total += pages;
+            }
+        }
+        // commit keeps the dbi handles opened here valid
+        CHECK_MDB(new_txn.commit());
+        return total;
+    }
+
+    // drops the map from this process and the data file from the page cache, so the
+    // next reads behave like the first ones after a restart
+    void evict_cache() {
+        MDB_envinfo info;
+        CHECK_MDB(mdb_env_info(env_, &info));
+        madvise(info.me_mapaddr, info.me_mapsize, MADV_DONTNEED);
+        mdb_filehandle_t fd;
+        CHECK_MDB(mdb_env_get_fd(env_, &fd));
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    enum class Readahead {
+        Normal = MADV_NORMAL,
+        Random = MADV_RANDOM,           // point lookups, kernel readahead off
+        Sequential = MADV_SEQUENTIAL    // full scans, aggressive kernel readahead
+    };
+
+    // applies to the whole map and every reader in this process, scans that should keep
+    // readahead under Random use Iterator::set_readahead instead
+    int set_readahead(Readahead policy) {
+        MDB_envinfo info;
+        int ret = mdb_env_info(env_, &info);
+        if (ret != MDB_SUCCESS) {
+            return ret;
+        }
+        // a map resize maps the file anew, the advice is applied again then
+        advice_ = (int) policy;
+        return madvise(info.me_mapaddr, info.me_mapsize, (int) policy) ? errno : MDB_SUCCESS;
+    }
+
+    // commit writes queued on an io_uring of depth runs with the data sync behind them,
+    // 0 goes back to pwritev. an error (ENOSYS, EPERM) leaves commits on pwritev
+    int set_uring(unsigned int depth) {
+        return mdb_env_set_uring(env_, depth);
+    }
+
+    // write txns hold up to pages dirty pages before spilling them to the map (default and
+    // minimum 2^17). the dirty list grows on demand; nested txns fail with MDB_INCOMPATIBLE
+    int set_dirty_max(size_t pages) {
+        return mdb_env_set_dirty_max(env_, pages);
+    }
+
+    unsigned int max_readers() {
+        unsigned int readers = 0;
+        CHECK_MDB(mdb_env_get_maxreaders(env_, &readers));
+        return readers;
+    }
+
+};
+
+std::atomic<uint64_t> DBEnv::next_id_{0};
+
+inline void PooledTxn::release() {
+    if (txn_) {
+        env_->release_read_txn(std::move(txn_));
+    }
+}
+
+inline void Transaction::leave_gate() {
+    if (gate_) {
+        gate_->leave_gate();
+        gate_ = nullptr;
+    }
+}
+
+inline int Transaction::renew() {
+    DBEnv *env = gate_ ? nullptr : DBEnv::of(txn_);
+    if (env) {
+        env->enter_gate(*this);
+    }
+    int ret = mdb_txn_renew(txn_);
+    if (ret != MDB_SUCCESS && env) {
+        leave_gate();
+    }
+    return ret;
+}
+
+class DBInstance{
+protected:
+    MDB_dbi dbi_ = 0;
+
+    // friendship is not inherited, subclasses reach the txn through here
+    static MDB_txn *txn_of(Transaction &txn) {
+        return txn.txn_;
+    }
+public:
+    DBInstance() = default;
+    int init(Transaction &txn, const string& db_name,unsigned int flag = MDB_CREATE){
+        return mdb_dbi_open(txn.txn_, db_name.data(), flag, &dbi_);
+    }
+    void close(DBEnv& env){
+        mdb_dbi_close(env.env_, dbi_);
+    }
+
+    int write(Transaction &txn, Slice key, Slice value, unsigned flag = MDB_NOOVERWRITE) {
+        MDB_val tmp_key = key.to_mdb_val();
+        MDB_val tmp_data = value.to_mdb_val();
+        return mdb_put(txn.txn_, dbi_, &tmp_key, &tmp_data, flag);
+    }
+
+    // MDB_RESERVE: makes room for a size byte value and points out at it in the dirty page,
+    // the caller fills it before the next write in this txn. not for MDB_DUPSORT dbis.
+    int reserve(Transaction &txn, Slice key, size_t size, char *&out, unsigned flag = MDB_NOOVERWRITE) {
+        MDB_val tmp_key = key.to_mdb_val();
+        MDB_val tmp_data;
+        tmp_data.mv_size = size;
+        tmp_data.mv_data = nullptr;
+        int ret = mdb_put(txn.txn_, dbi_, &tmp_key, &tmp_data, flag | MDB_RESERVE);
+        out = ret == MDB_SUCCESS ? (char *) tmp_data.mv_data : nullptr;
+        return ret;
+    }
+
+    // serializes straight into the page: fill(char *data, size_t size) writes the value
+    template <typename F>
+    int write_reserve(Transaction &txn, Slice key, size_t size, F &&fill, unsigned flag = MDB_NOOVERWRITE) {
+        char *data;
+        int ret = reserve(txn, key, size, data, flag);
+        if (ret == MDB_SUCCESS) {
+            fill(data, size);
+        }
+        return ret;
+    }
+
+    // batch is any range of key/value pairs convertible to Slice. the batch is sorted
+    // (unless it already is) and every key above the current last key is appended with
+    // MDB_APPEND, so pages are filled left to right without a split search. with
+    // MDB_NOOVERWRITE keys already stored are skipped and the rest is still written:
+    // written gets the rows stored, without it the call returns MDB_KEYEXIST instead
+    template <typename Range>
+    int write_batch(Transaction &txn, const Range &batch, unsigned flag = MDB_NOOVERWRITE, size_t *written = nullptr) {
+        using Entry = std::pair<MDB_val, MDB_val>;
+        std::vector<Entry> entries;
+        for (const auto &kv : batch) {
+            Slice key(kv.first), value(kv.second);
+            entries.emplace_back(key.to_mdb_val(), value.to_mdb_val());
+        }
+        auto less = [&](const Entry &a, const Entry &b) {
+            return mdb_cmp(txn.txn_, dbi_, &a.first, &b.first) < 0;
+        };
+        if (!std::is_sorted(entries.begin(), entries.end(), less)) {
+            std::stable_sort(entries.begin(), entries.end(), less);
+        }
+
+        MDB_cursor *cursor = nullptr;
+        int ret = mdb_cursor_open(txn.txn_, dbi_, &cursor);
+        if (ret != MDB_SUCCESS) {
+            return ret;
+        }
+        auto append_from = entries.begin();
+        Entry last;
+        ret = mdb_cursor_get(cursor, &last.first, &last.second, MDB_LAST);
+        if (ret == MDB_SUCCESS) {
+            append_from = std::upper_bound(entries.begin(), entries.end(), last, less);
+        } else if (ret != MDB_NOTFOUND) {
+            mdb_cursor_close(cursor);
+            return ret;
+        }
+
+        size_t counter = 0, skipped = 0;
+        ret = MDB_SUCCESS;
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            unsigned put_flag = flag;
+            // equal keys inside the batch must take the regular path, MDB_APPEND rejects them
+            if (it >= append_from && (it == append_from || less(*(it - 1), *it))) {
+                put_flag |= MDB_APPEND;
+            }
+            ret = mdb_cursor_put(cursor, &it->first, &it->second, put_flag);
+            if (ret == MDB_SUCCESS) {
+                ++counter;
+            } else if (ret == MDB_KEYEXIST) {
+                ++skipped;
+                ret = MDB_SUCCESS;
+            } else {
+                break;
+            }
+        }
+        mdb_cursor_close(cursor);
+        if (written) {
+            *written = counter;
+        } else if (ret == MDB_SUCCESS && skipped) {
+            ret = MDB_KEYEXIST;
+        }
+        return ret;
+    }
+
+    Iterator new_iterator(Transaction &txn) {
+        Iterator iter;
+        if (mdb_cursor_open(txn.txn_, dbi_, &iter.cursor_) == MDB_SUCCESS && !txn.read_only_) {
+            iter.link(&txn);
+        }
+        return iter;
+    }
+
+    // iterator over range, already positioned on its first record
+    RangeIterator new_range_iterator(Transaction &txn, KeyRange range) {
+        RangeIterator iter(new_iterator(txn), std::move(range));
+        iter.seek();
+        return iter;
+    }
+
+    // looks the keys up in key order with one cursor, a key past the current leaf is found
+    // from the lowest branch that still covers it (see mdb_cursor_set) instead of the root.
+    // values[i] is the value of keys[i], empty when missing; returns the number found.
+    size_t multi_get(Transaction &txn, const vector<Slice> &keys, vector<Slice> &values,
+                     vector<bool> *found = nullptr) {
+        values.assign(keys.size(), Slice());
+        if (found) {
+            found->assign(keys.size(), false);
+        }
+        if (keys.size() == 1) {
+            MDB_val tmp_key = Slice(keys[0]).to_mdb_val(), tmp_value;
+            if (mdb_get(txn.txn_, dbi_, &tmp_key, &tmp_value) != MDB_SUCCESS) {
+                return 0;
+            }
+            values[0] = tmp_value;
+            if (found) {
+                (*found)[0] = true;
+            }
+            return 1;
+        }
+        // memcmp ordered dbis sort on the big endian 8 byte prefix and only compare whole
+        // keys on ties. the wrapper never installs a custom comparator.
+        unsigned int db_flags = 0;
+        mdb_dbi_flags(txn.txn_, dbi_, &db_flags);
+        bool memcmp_order = !(db_flags & (MDB_REVERSEKEY | MDB_INTEGERKEY));
+        vector<pair<uint64_t, uint32_t>> order(keys.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            uint64_t prefix = 0;
+            if (memcmp_order) {
+                unsigned char buf[8] = {0};
+                memcpy(buf, keys[i].data(), std::min<size_t>(keys[i].size(), 8));
+                for (auto c : buf) {
+                    prefix = prefix << 8 | c;
+                }
+            }
+            order[i] = {prefix, i};
+        }
+        auto less = [&](const pair<uint64_t, uint32_t> &a, const pair<uint64_t, uint32_t> &b) {
+            if (a.first != b.first) {
+                return a.first < b.first;
+            }
+            return compare(txn, keys[a.second], keys[b.second]) < 0;
+        };
+        if (!std::is_sorted(order.begin(), order.end(), less)) {
+            std::sort(order.begin(), order.end(), less);
+        }
+        MDB_cursor *cursor;
+        if (mdb_cursor_open(txn.txn_, dbi_, &cursor) != MDB_SUCCESS) {
+            return 0;
+        }
+        size_t counter = 0;
+        for (auto &entry : order) {
+            uint32_t i = entry.second;
+            MDB_val tmp_key = Slice(keys[i]).to_mdb_val(), tmp_value;
+            if (mdb_cursor_get(cursor, &tmp_key, &tmp_value, MDB_SET_KEY) == MDB_SUCCESS) {
+                values[i] = tmp_value;
+                if (found) {
+                    (*found)[i] = true;
+                }
+                ++counter;
+            }
+        }
+        mdb_cursor_close(cursor);
+        return counter;
+    }
+
+    // point lookups with the descents interleaved (mdb_get_batch), for unrelated keys on
+    // trees larger than the cpu caches. same results as multi_get.
+    size_t get_batch(Transaction &txn, const vector<Slice> &keys, vector<Slice> &values,
+                     vector<bool> *found = nullptr) {
+        if (keys.size() == 1) {
+            return multi_get(txn, keys, values, found);
+        }
+        vector<MDB_val> tmp_keys(keys.size()), tmp_values(keys.size());
+        vector<int> rcs(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            tmp_keys[i] = Slice(keys[i]).to_mdb_val();
+        }
+        values.assign(keys.size(), Slice());
+        if (found) {
+            found->assign(keys.size(), false);
+        }
+        int ret = mdb_get_batch(txn.txn_, dbi_, tmp_keys.data(), tmp_values.data(), rcs.data(), keys.size());
+        CHECK_MDB(ret);
+        if (ret != MDB_SUCCESS) {
+            return 0;
+        }
+        size_t counter = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (rcs[i] == MDB_SUCCESS) {
+                values[i] = tmp_values[i];
+                if (found) {
+                    (*found)[i] = true;
+                }
+                ++counter;
+            }
+        }
+        return counter;
+    }
+
+    // key order of the db, < 0, 0 or > 0 like memcmp
+    int compare(Transaction &txn, Slice a, Slice b) {
+        MDB_val tmp_a = a.to_mdb_val();
+        MDB_val tmp_b = b.to_mdb_val();
+        return mdb_cmp(txn.txn_, dbi_, &tmp_a, &tmp_b);
+    }
+
+    // up to parts-1 ascending keys cutting the db into ranges of about equal size, taken
+    // from the upper tree levels (mdb_dbi_split). copied, so usable in other txns
+    vector<string> split_keys(Transaction &txn, unsigned int parts) {
+        vector<string> out;
+        if (parts < 2) {
+            return out;
+        }
+        vector<MDB_val> tmp_keys(parts - 1);
+        unsigned int count = 0;
+        auto ret = mdb_dbi_split(txn.txn_, dbi_, parts, tmp_keys.data(), &count);
+        CHECK_MDB(ret);
+        for (unsigned int i = 0; i < count; ++i) {
+            out.push_back(Slice(tmp_keys[i]).to_string());
+        }
+        return out;
+    }
+
+    // full scan by threads readers, each with its own read txn on one snapshot. the db is
+    // cut into parts ranges (default threads) handed out dynamically, f(part, key, value)
+    // runs concurrently for different parts and in key order within one. out_rows gets the
+    // rows; when a reader can not begin or renew its txn nothing is scanned and the error
+    // is returned
+    template <typename F>
+    int parallel_scan(DBEnv &env, unsigned int threads, F &&f, size_t &out_rows, unsigned int parts = 0) {
+        if (!parts) {
+            parts = threads;
+        }
+        // one slot per thread of the team, which can be smaller than threads
+        vector<size_t> txn_ids;
+        vector<int> rets;
+        vector<string> cuts;
+        std::atomic<size_t> rows{0};
+        bool same = false;
+        int error = MDB_SUCCESS;
+#pragma omp parallel num_threads(threads)
+        {
+            unsigned int tid = omp_get_thread_num();
+#pragma omp single
+            {
+                txn_ids.assign(omp_get_num_threads(), 0);
+                rets.assign(omp_get_num_threads(), MDB_SUCCESS);
+            }
+            Transaction txn;
+            int ret = env.begin_transaction(txn, MDB_RDONLY);
+            // a commit between two begins splits the snapshot, renew all until none did
+            for (;;) {
+                rets[tid] = ret;
+                txn_ids[tid] = ret == MDB_SUCCESS ? mdb_txn_id(txn.txn_) : 0;
+#pragma omp barrier
+#pragma omp single
+                {
+                    for (int r : rets) {
+                        if (r != MDB_SUCCESS) {
+                            error = r;
+                        }
+                    }
+                    same = std::all_of(txn_ids.begin(), txn_ids.end(),
+                                       [&](size_t id) { return id == txn_ids[0]; });
+                }
+                if (same || error != MDB_SUCCESS) {
+                    break;
+                }
+                txn.reset();
+                ret = txn.renew();
+            }
+            if (error == MDB_SUCCESS) {
+#pragma omp single
+                cuts = split_keys(txn, parts);
+
+                auto iter = new_iterator(txn);
+                size_t counter = 0;
+                size_t nparts = cuts.size() + 1;
+#pragma omp for schedule(dynamic, 1)
+                for (size_t p = 0; p < nparts; ++p) {
+                    if (p == 0) {
+                        iter.seek_first();
+                    } else {
+                        iter.seek_to(cuts[p - 1]);
+                    }
+                    for (; iter.valid(); iter.next()) {
+                        if (p + 1 < nparts && compare(txn, iter.key(), cuts[p]) >= 0) {
+                            break;
+                        }
+                        f(p, iter.key(), iter.value());
+                        ++counter;
+                    }
+                }
+                rows += counter;
+                iter.close();
+            }
+            txn.abort();
+        }
+        out_rows = rows;
+        return error;
+    }
+
+    int stat(Transaction &txn, MDB_stat &out_stat) {
+        return mdb_stat(txn.txn_, dbi_, &out_stat);
+    }
+
+    int drop(Transaction &txn, bool del = false) {
+        return mdb_drop(txn.txn_, dbi_, del ? 1 : 0);
+    }
+
+    int del(Transaction &txn, Slice &key) {
+        MDB_val tmp_key, tmp_data;
+        tmp_key = key.to_mdb_val();
+        return mdb_del(txn.txn_, dbi_, &tmp_key, &tmp_data);
+    }
+
+    bool get(Transaction &txn, Slice key, Slice &out_value) {
+        MDB_val tmp_value;
+        MDB_val tmp_key = key.to_mdb_val();
+        auto ret = mdb_get(txn.txn_, dbi_, &tmp_key, &tmp_value);
+        CHECK_MDB(ret);
+        if (ret == MDB_SUCCESS) {
+            out_value = tmp_value;
+            return true;
+        }
+
+        return false;
+    }
+
+};
+
+// dbi opened with MDB_INTEGERKEY, keys are stored as native endian T so the tree uses the
+// integer comparators instead of mdb_cmp_memn. T must be unsigned int or size_t sized.
+template <typename T>
+class IntDBInstance : public DBInstance {
+    static_assert(std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value,
+                  "IntDBInstance key must be uint32_t or uint64_t");
+    static_assert(sizeof(T) == sizeof(unsigned int) || sizeof(T) == sizeof(size_t),
+                  "MDB_INTEGERKEY needs unsigned int or size_t sized keys");
+
+    static Slice key_slice(const T &key) {
+        return Slice((const char *) &key, sizeof(T));
+    }
+
+public:
+    int init(Transaction &txn, const string& db_name, unsigned int flag = MDB_CREATE) {
+        return DBInstance::init(txn, db_name, flag | MDB_INTEGERKEY);
+    }
+
+    int write(Transaction &txn, T key, Slice value, unsigned flag = MDB_NOOVERWRITE) {
+        return DBInstance::write(txn, key_slice(key), value, flag);
+    }
+
+    int del(Transaction &txn, T key) {
+        Slice tmp_key = key_slice(key);
+        return DBInstance::del(txn, tmp_key);
+    }
+
+    bool get(Transaction &txn, T key, Slice &out_value) {
+        return DBInstance::get(txn, key_slice(key), out_value);
+    }
+
+    static T key_of(const Slice &key) {
+        T ret;
+        assert(key.size() == sizeof(T));
+        memcpy(&ret, key.data(), sizeof(T));
+        return ret;
+    }
+};
+
+// fixed size items viewed in place in the map, valid until the txn ends. items of a
+// dupsort sub-page are not aligned to T, so they are read with memcpy.
+template <typename T>
+class ItemSpan {
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    ItemSpan() = default;
+
+    ItemSpan(const MDB_val &val) : data_((const char *) val.mv_data), size_(val.mv_size / sizeof(T)) {}
+
+    const char *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    T operator[](size_t i) const {
+        T item;
+        memcpy(&item, data_ + i * sizeof(T), sizeof(T));
+        return item;
+    }
+
+    void copy_to(T *out) const {
+        memcpy(out, data_, size_ * sizeof(T));
+    }
+};
+
+// one key to many fixed size T values (MDB_DUPSORT|MDB_DUPFIXED). whole pages of
+// duplicates are read with MDB_GET_MULTIPLE/MDB_NEXT_MULTIPLE and written with
+// MDB_MULTIPLE. uint32_t/uint64_t items are stored native endian with MDB_INTEGERDUP,
+// any other T is ordered by memcmp.
+template <typename T>
+class MultiDBInstance : public DBInstance {
+    static_assert(std::is_trivially_copyable<T>::value, "MultiDBInstance item must be trivially copyable");
+
+    static constexpr bool kIntegerDup = std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value;
+
+    static MDB_val item_val(const T &item) {
+        MDB_val val;
+        val.mv_size = sizeof(T);
+        val.mv_data = (void *) &item;
+        return val;
+    }
+
+public:
+    int init(Transaction &txn, const string& db_name, unsigned int flag = MDB_CREATE) {
+        return DBInstance::init(txn, db_name,
+                                flag | MDB_DUPSORT | MDB_DUPFIXED | (kIntegerDup ? MDB_INTEGERDUP : 0));
+    }
+
+    int put(Transaction &txn, Slice key, const T &item, unsigned flag = MDB_NODUPDATA) {
+        MDB_val tmp_key = key.to_mdb_val();
+        MDB_val tmp_data = item_val(item);
+        return mdb_put(txn_of(txn), dbi_, &tmp_key, &tmp_data, flag);
+    }
+
+    // n items in one MDB_MULTIPLE put, sorted input fills the dup pages in order.
+    // duplicates already stored are left alone but, unlike put's MDB_NODUPDATA, do not
+    // fail the put and are counted in written: it is the items processed, not newly stored
+    int put_multiple(Transaction &txn, Slice key, const T *items, size_t n, size_t *written = nullptr) {
+        MDB_cursor *cursor;
+        int ret = mdb_cursor_open(txn_of(txn), dbi_, &cursor);
+        if (ret != MDB_SUCCESS) {
+            return ret;
+        }
+        MDB_val tmp_key = key.to_mdb_val();
+        MDB_val tmp_data[2];
+        tmp_data[0].mv_size = sizeof(T);
+        tmp_data[0].mv_data = (void *) items;
+        tmp_data[1].mv_size = n;
+        tmp_data[1].mv_data = nullptr;
+        ret = n ? mdb_cursor_put(cursor, &tmp_key, tmp_data, MDB_MULTIPLE) : MDB_SUCCESS;
+        mdb_cursor_close(cursor);
+        if (written) {
+            *written = n ? tmp_data[1].mv_size : 0;
+        }
+        return ret;
+    }
+
+    int del(Transaction &txn, Slice key, const T &item) {
+        MDB_val tmp_key = key.to_mdb_val();
+        MDB_val tmp_data = item_val(item);
+        return mdb_del(txn_of(txn), dbi_, &tmp_key, &tmp_data);
+    }
+
+    // number of items of key, 0 when missing
+    size_t count(Transaction &txn, Slice key) {
+        MDB_cursor *cursor;
+        size_t n = 0;
+        if (mdb_cursor_open(txn_of(txn), dbi_, &cursor) != MDB_SUCCESS) {
+            return 0;
+        }
+        MDB_val tmp_key = key.to_mdb_val(), tmp_data;
+        if (mdb_cursor_get(cursor, &tmp_key, &tmp_data, MDB_SET) == MDB_SUCCESS) {
+            mdb_cursor_count(cursor, &n);
+        }
+        mdb_cursor_close(cursor);
+        return n;
+    }
+
+    // calls f(ItemSpan<T>) once per page of items of key, in item order
+    template <typename F>
+    int for_each_page(Transaction &txn, Slice key, F &&f) {
+        MDB_cursor *cursor;
+        int ret = mdb_cursor_open(txn_of(txn), dbi_, &cursor);
+        if (ret != MDB_SUCCESS) {
+            return ret;
+        }
+        MDB_val tmp_key = key.to_mdb_val(), tmp_data;
+        ret = mdb_cursor_get(cursor, &tmp_key, &tmp_data, MDB_SET);
+        if (ret == MDB_SUCCESS) {
+            ret = mdb_cursor_get(cursor, &tmp_key, &tmp_data, MDB_GET_MULTIPLE);
+            while (ret == MDB_SUCCESS) {
+                f(ItemSpan<T>(tmp_data));
+                ret = mdb_cursor_get(cursor, &tmp_key, &tmp_data, MDB_NEXT_MULTIPLE);
+            }
+            if (ret == MDB_NOTFOUND) {
+                ret = MDB_SUCCESS;
+            }
+        }
+        mdb_cursor_close(cursor);
+        return ret;
+    }
+
+    // appends every item of key to out
+    int get_all(Transaction &txn, Slice key, vector<T> &out) {
+        return for_each_page(txn, key, [&](ItemSpan<T> span) {
+            size_t old_size = out.size();
+            out.resize(old_size + span.size());
+            span.copy_to(out.data() + old_size);
+        });
+    }
+};
+
+// puts and deletes submitted to WriteCoordinator as one unit, applied all or nothing.
+// keys and values are copied into one buffer, ops refer into it by offset.
+class WriteBatch {
+    struct Op {
+        DBInstance *db;
+        bool del;
+        unsigned flag;
+        size_t key_off, key_len;
+        size_t value_off, value_len;
+    };
+    string buf_;
+    vector<Op> ops_;
+    friend class WriteCoordinator;
+
+    size_t append(Slice data) {
+        size_t off = buf_.size();
+        buf_.append(data.data(), data.size());
+        return off;
+    }
+
+public:
+    WriteBatch &put(DBInstance &db, Slice key, Slice value, unsigned flag = MDB_NOOVERWRITE) {
+        size_t key_off = append(key);
+        size_t value_off = append(value);
+        ops_.push_back({&db, false, flag, key_off, key.size(), value_off, value.size()});
+        return *this;
+    }
+
+    // deleting a missing key is not an error
+    WriteBatch &del(DBInstance &db, Slice key) {
+        size_t key_off = append(key);
+        ops_.push_back({&db, true, 0, key_off, key.size(), 0, 0});
+        return *this;
+    }
+
+    size_t size() const {
+        return ops_.size();
+    }
+
+    bool empty() const {
+        return ops_.empty();
+    }
+
+    void clear() {
+        buf_.clear();
+        ops_.clear();
+    }
+};
+
+// group commit for many writer threads. producers push batches onto a lock-free MPSC
+// queue, a single committer thread applies up to max_batch_ops of them to one write txn,
+// waiting at most max_latency_us for more to arrive, commits once and completes every
+// producer's future with the result. a batch that fails is completed with its error and
+// the group is replayed without it; a failed commit fails the whole group. MDB_MAP_FULL
+// from a batch or the commit grows the map (see DBEnv::set_map_growth) and replays the
+// whole group, batches only fail with it when the map can not grow.
+class WriteCoordinator {
+public:
+    struct Options {
+        size_t max_batch_ops = 1024;
+        uint64_t max_latency_us = 0;
+    };
+
+    struct Stats {
+        uint64_t commits;
+        uint64_t batches;
+        uint64_t ops;
+    };
+
+private:
+    struct Request {
+        WriteBatch batch;
+        std::promise<int> done;
+        std::function<void(int)> callback;
+        std::atomic<Request *> next{nullptr};
+    };
+
+    DBEnv &env_;
+    Options options_;
+    // intrusive Vyukov queue: producers exchange head_, the committer owns tail_
+    Request stub_;
+    std::atomic<Request *> head_{&stub_};
+    Request *tail_ = &stub_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> idle_{false};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<uint64_t> commits_{0}, batches_{0}, ops_{0};
+    vector<Request *> group_;
+    vector<int> results_;
+    std::thread committer_;
+
+    void push(Request *req) {
+        req->next.store(nullptr, std::memory_order_relaxed);
+        Request *prev = head_.exchange(req);
+        prev->next.store(req, std::memory_order_release);
+    }
+
+    // nullptr when empty or when a producer is between the exchange and the link
+    Request *pop() {
+        Request *tail = tail_;
+        Request *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            tail_ = tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load()) {
+            return nullptr;
+        }
+        push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    bool empty() {
+        return tail_ == head_.load() && !tail_->next.load(std::memory_order_acquire);
+    }
+
+    void enqueue(Request *req) {
+        push(req);
+        if (idle_.load()) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_cv_.notify_one();
+        }
+    }
+
+    int apply(Transaction &txn, WriteBatch &batch) {
+        for (auto &op : batch.ops_) {
+            Slice key(batch.buf_.data() + op.key_off, op.key_len);
+            int ret;
+            if (op.del) {
+                ret = op.db->del(txn, key);
+                if (ret == MDB_NOTFOUND) {
+                    ret = MDB_SUCCESS;
+                }
+            } else {
+                Slice value(batch.buf_.data() + op.value_off, op.value_len);
+                ret = op.db->write(txn, key, value, op.flag);
+            }
+            if (ret != MDB_SUCCESS) {
+                return ret;
+            }
+        }
+        return MDB_SUCCESS;
+    }
+
+    void commit_group() {
+        results_.assign(group_.size(), MDB_SUCCESS);
+        for (;;) {
+            Transaction txn;
+            int ret = env_.begin_transaction(txn, 0);
+            // no resize happens while the txn holds the gate
+            size_t resizes = env_.map_resizes();
+            bool replay = false;
+            for (size_t i = 0; ret == MDB_SUCCESS && i < group_.size(); ++i) {
+                if (results_[i] != MDB_SUCCESS) {
+                    continue;
+                }
+                int batch_ret = apply(txn, group_[i]->batch);
+                if (batch_ret != MDB_SUCCESS) {
+                    txn.abort();
+                    // a full map is grown and the whole group replayed
+                    if (batch_ret != MDB_MAP_FULL || env_.grow_map(resizes) != MDB_SUCCESS) {
+                        results_[i] = batch_ret;
+                    }
+                    replay = true;
+                    break;
+                }
+            }
+            if (replay) {
+                continue;
+            }
+            if (ret == MDB_SUCCESS) {
+                ret = txn.commit();
+                if (ret == MDB_MAP_FULL && env_.grow_map(resizes) == MDB_SUCCESS) {
+                    continue;
+                }
+            }
+            for (size_t i = 0; i < group_.size(); ++i) {
+                if (results_[i] == MDB_SUCCESS) {
+                    results_[i] = ret;
+                }
+            }
+            break;
+        }
+        size_t ops = 0;
+        for (auto req : group_) {
+            ops += req->batch.size();
+        }
+        commits_.fetch_add(1, std::memory_order_relaxed);
+        batches_.fetch_add(group_.size(), std::memory_order_relaxed);
+        ops_.fetch_add(ops, std::memory_order_relaxed);
+        for (size_t i = 0; i < group_.size(); ++i) {
+            if (group_[i]->callback) {
+                group_[i]->callback(results_[i]);
+            } else {
+                group_[i]->done.set_value(results_[i]);
+            }
+            delete group_[i];
+        }
+        group_.clear();
+    }
+
+    void run() {
+        for (;;) {
+            Request *req = pop();
+            if (!req) {
+                if (!empty()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (stop_.load()) {
+                    break;
+                }
+                std::unique_lock<std::mutex> lock(idle_mutex_);
+                idle_.store(true);
+                idle_cv_.wait_for(lock, std::chrono::milliseconds(10),
+                                  [this] { return stop_.load() || !empty(); });
+                idle_.store(false);
+                continue;
+            }
+            size_t ops = req->batch.size();
+            group_.push_back(req);
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::microseconds(options_.max_latency_us);
+            while (ops < options_.max_batch_ops) {
+                if ((req = pop())) {
+                    ops += req->batch.size();
+                    group_.push_back(req);
+                    continue;
+                }
+                if (!options_.max_latency_us || stop_.load() ||
+                    std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+            commit_group();
+        }
+    }
+
+public:
+    explicit WriteCoordinator(DBEnv &env) : WriteCoordinator(env, Options()) {}
+
+    WriteCoordinator(DBEnv &env, Options options)
+            : env_(env), options_(options), committer_(&WriteCoordinator::run, this) {}
+
+    // drains every batch submitted so far, submit must not race with destruction
+    ~WriteCoordinator() {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_cv_.notify_one();
+        }
+        committer_.join();
+    }
+
+    WriteCoordinator(const WriteCoordinator &) = delete;
+
+    WriteCoordinator &operator=(const WriteCoordinator &) = delete;
+
+    // the future gets MDB_SUCCESS once the group holding the batch is committed
+    std::future<int> submit(WriteBatch &&batch) {
+        auto req = new Request;
+        req->batch = std::move(batch);
+        auto done = req->done.get_future();
+        enqueue(req);
+        return done;
+    }
+
+    // callback runs on the committer thread and must not block
+    void submit(WriteBatch &&batch, std::function<void(int)> callback) {
+        auto req = new Request;
+        req->batch = std::move(batch);
+        req->callback = std::move(callback);
+        enqueue(req);
+    }
+
+    Stats stats() const {
+        return {commits_.load(), batches_.load(), ops_.load()};
+    }
+};
+
+#ifdef __cpp_impl_coroutine
+// lazy coroutine, starts when awaited and resumes the awaiting coroutine when done
+template <typename T>
+class Task;
+
+template <typename T>
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    auto final_suspend() noexcept {
+        struct Final {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) noexcept {
+                auto &promise = std::coroutine_handle<typename Task<T>::promise_type>::from_address(
+                        handle.address()).promise();
+                return promise.continuation ? promise.continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+        return Final{};
+    }
+
+    void unhandled_exception() { std::terminate(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase<T> {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+
+    void return_value(T v) { value.emplace(std::move(v)); }
+
+    T result() { return std::move(*value); }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase<void> {
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void result() {}
+};
+
+template <typename T = void>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task(const Task &) = delete;
+
+    Task &operator=(const Task &) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// eager, self destroying coroutine used to start a Task from plain code
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        std::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// runs the task on the calling thread until its first suspension, the rest runs wherever
+// it is resumed
+inline Detached spawn(Task<void> task) {
+    co_await task;
+}
+
+// blocks the calling thread until the task is done, must not be called on a worker
+template <typename T>
+T sync_wait(Task<T> task) {
+    std::promise<T> result;
+    auto future = result.get_future();
+    [](Task<T> task, std::promise<T> &result) -> Detached {
+        if constexpr (std::is_void<T>::value) {
+            co_await task;
+            result.set_value();
+        } else {
+            result.set_value(co_await task);
+        }
+    }(std::move(task), result);
+    return future.get();
+}
+
+// unit of work for an AsyncExecutor worker. ops that read run with the worker's read
+// txn renewed, the txn is reset again before the waiting coroutine is resumed.
+struct AsyncOp {
+    std::coroutine_handle<> handle;
+    bool reads = false;
+
+    virtual ~AsyncOp() = default;
+
+    virtual void run(Transaction &txn) {}
+};
+
+// work-stealing pool, each worker owns a read txn of the env. ops posted from a worker go
+// to its own deque (taken LIFO), ops from other threads are spread round robin and idle
+// workers steal from the front of the others' deques.
+class AsyncExecutor {
+    struct Worker {
+        std::mutex mutex;
+        std::deque<AsyncOp *> ops;
+    };
+
+    struct Current {
+        AsyncExecutor *executor = nullptr;
+        size_t index = 0;
+        Transaction *txn = nullptr;
+    };
+
+    DBEnv &env_;
+    vector<unique_ptr<Worker>> workers_;
+    vector<std::thread> threads_;
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> sleepers_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    static thread_local Current current_;
+
+    AsyncOp *pop(size_t index) {
+        auto &worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.ops.empty()) {
+            return nullptr;
+        }
+        auto op = worker.ops.back();
+        worker.ops.pop_back();
+        return op;
+    }
+
+    AsyncOp *steal(size_t index) {
+        for (size_t i = 1; i < workers_.size(); ++i) {
+            auto &victim = *workers_[(index + i) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.ops.empty()) {
+                auto op = victim.ops.front();
+                victim.ops.pop_front();
+                return op;
+            }
+        }
+        return nullptr;
+    }
+
+    void execute(AsyncOp *op, Transaction &txn) {
+        if (op->reads) {
+            int ret = txn.renew();
+            CHECK_MDB(ret);
+            if (ret == MDB_SUCCESS) {
+                op->run(txn);
+                txn.reset();
+            }
+        }
+    }
+
+    void work(size_t index) {
+        Transaction txn = env_.new_transaction(MDB_RDONLY);
+        txn.reset();
+        current_ = {this, index, &txn};
+        for (;;) {
+            AsyncOp *op = pop(index);
+            if (!op) {
+                op = steal(index);
+            }
+            if (op) {
+                pending_.fetch_sub(1);
+                execute(op, txn);
+                op->handle.resume();
+                continue;
+            }
+            if (stop_.load() && !pending_.load()) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            sleepers_.fetch_add(1);
+            idle_cv_.wait(lock, [this] { return stop_.load() || pending_.load(); });
+            sleepers_.fetch_sub(1);
+        }
+        current_ = {};
+    }
+
+public:
+    AsyncExecutor(DBEnv &env, size_t threads) : env_(env) {
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back(new Worker);
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back(&AsyncExecutor::work, this, i);
+        }
+    }
+
+    // runs every op posted so far, nothing may be posted during destruction
+    ~AsyncExecutor() {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_cv_.notify_all();
+        }
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    AsyncExecutor(const AsyncExecutor &) = delete;
+
+    AsyncExecutor &operator=(const AsyncExecutor &) = delete;
+
+    size_t size() const {
+        return workers_.size();
+    }
+
+    void post(AsyncOp *op) {
+        pending_.fetch_add(1);
+        size_t index = current_.executor == this ? current_.index : next_++ % workers_.size();
+        {
+            std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+            workers_[index]->ops.push_back(op);
+        }
+        if (sleepers_.load()) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_cv_.notify_one();
+        }
+    }
+
+    // on a worker of this executor the op runs right away with the worker's txn
+    bool run_inline(AsyncOp *op) {
+        if (current_.executor != this) {
+            return false;
+        }
+        execute(op, *current_.txn);
+        return true;
+    }
+
+    // co_await executor.schedule() continues the coroutine on a worker
+    auto schedule() {
+        struct Awaiter : AsyncOp {
+            AsyncExecutor *executor;
+
+            explicit Awaiter(AsyncExecutor *executor) : executor(executor) {}
+
+            bool await_ready() { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                this->handle = handle;
+                executor->post(this);
+            }
+
+            void await_resume() {}
+        };
+        return Awaiter(this);
+    }
+};
+
+thread_local AsyncExecutor::Current AsyncExecutor::current_;
+
+// awaitable front end of a db: reads run on the executor (inline when the caller already
+// is a worker), writes go through the WriteCoordinator and resume on a worker. keys and
+// bounds passed in must stay valid until the co_await completes.
+class AsyncDB {
+    AsyncExecutor &executor_;
+    WriteCoordinator &writer_;
+    DBInstance db_;
+
+    template <typename Op>
+    struct Awaiter : Op {
+        using Op::Op;
+
+        bool await_ready() { return this->db->executor_.run_inline(this); }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            this->handle = handle;
+            this->db->executor_.post(this);
+        }
+
+        auto await_resume() { return std::move(this->result); }
+    };
+
+    struct GetOp : AsyncOp {
+        AsyncDB *db;
+        Slice key;
+        std::optional<string> result;
+
+        GetOp(AsyncDB *db, Slice key) : db(db), key(key) {
+            reads = true;
+        }
+
+        void run(Transaction &txn) override {
+            Slice value;
+            if (db->db_.get(txn, key, value)) {
+                result.emplace(value.data(), value.size());
+            }
+        }
+    };
+
+    struct ScanOp : AsyncOp {
+        AsyncDB *db;
+        Slice begin, end;
+        size_t limit;
+        vector<pair<string, string>> result;
+
+        ScanOp(AsyncDB *db, Slice begin, Slice end, size_t limit)
+                : db(db), begin(begin), end(end), limit(limit) {
+            reads = true;
+        }
+
+        void run(Transaction &txn) override {
+            auto iter = db->db_.new_iterator(txn);
+            for (iter.seek_to(begin); iter.valid(); iter.next()) {
+                if ((!end.empty() && db->db_.compare(txn, iter.key(), end) >= 0) ||
+                    (limit && result.size() >= limit)) {
+                    break;
+                }
+                result.emplace_back(iter.key().to_string(), iter.value().to_string());
+            }
+        }
+    };
+
+public:
+    AsyncDB(AsyncExecutor &executor, WriteCoordinator &writer, DBInstance db)
+            : executor_(executor), writer_(writer), db_(db) {}
+
+    // std::optional<string>, empty when the key is missing
+    auto get(Slice key) {
+        return Awaiter<GetOp>(this, key);
+    }
+
+    // rows in [begin, end), empty end scans to the last key, 0 limit means no limit
+    auto scan(Slice begin, Slice end = Slice(), size_t limit = 0) {
+        return Awaiter<ScanOp>(this, begin, end, limit);
+    }
+
+    // MDB_SUCCESS or the error of the batch or of the group commit holding it
+    auto write(WriteBatch &&batch) {
+        struct WriteAwaiter : AsyncOp {
+            AsyncDB *db;
+            WriteBatch batch;
+            int result = MDB_SUCCESS;
+
+            WriteAwaiter(AsyncDB *db, WriteBatch &&batch) : db(db), batch(std::move(batch)) {}
+
+            bool await_ready() { return batch.empty(); }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                this->handle = handle;
+                db->writer_.submit(std::move(batch), [this](int ret) {
+                    result = ret;
+                    db->executor_.post(this);
+                });
+            }
+
+            int await_resume() { return result; }
+        };
+        return WriteAwaiter(this, std::move(batch));
+    }
+};
+#endif
+
+// HDR style log-linear histogram of latencies in ns. values below kSubCount are kept exact,
+// every power of two above is split into kSubCount/2 buckets. percentiles report the top of
+// a bucket, which spans up to 1/64 of its values, so they read up to ~1.6% high.
+class LatencyHistogram {
+    static constexpr int kSubBits = 7;
+    static constexpr uint64_t kSubCount = 1ULL << kSubBits;
+    static constexpr uint64_t kHalf = kSubCount / 2;
+    static constexpr size_t kBuckets = kSubCount + (64 - kSubBits) * kHalf;
+
+    vector<uint64_t> counts_ = vector<uint64_t>(kBuckets, 0);
+    uint64_t total_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+
+    static size_t index_of(uint64_t value) {
+        if (value < kSubCount) {
+            return value;
+        }
+        int shift = 63 - __builtin_clzll(value) - (kSubBits - 1);
+        return kSubCount + (shift - 1) * kHalf + ((value >> shift) - kHalf);
+    }
+
+    static uint64_t highest_of(size_t index) {
+        if (index < kSubCount) {
+            return index;
+        }
+        int shift = (index - kSubCount) / kHalf + 1;
+        uint64_t sub = (index - kSubCount) % kHalf + kHalf;
+        return (sub << shift) + ((1ULL << shift) - 1);
+    }
+
+public:
+    void record(uint64_t value) {
+        ++counts_[index_of(value)];
+        ++total_;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for (size_t i = 0; i < kBuckets; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t percentile(double p) const {
+        if (total_ == 0) {
+            return 0;
+        }
+        uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100 * total_));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= target) {
+                return std::min(highest_of(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return total_; }
+
+    uint64_t min() const { return total_ ? min_ : 0; }
+
+    uint64_t max() const { return max_; }
+};
+
+// records the lifetime of the scope into hist, does nothing when hist is null
+class ScopedLatency {
+    LatencyHistogram *hist_;
+    std::chrono::steady_clock::time_point start_;
+public:
+    explicit ScopedLatency(LatencyHistogram *hist) : hist_(hist) {
+        if (hist_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedLatency() {
+        if (hist_) {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            hist_->record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+};
+
+void print_stats(const char* func_name, int time_cost,size_t counter){
+    cout.setf(ios::left);
+//    std::cout << std::setw(32) <<func_name  << " timecost:" << time_cost << " μs"<<std::endl;
+    std::cout << std::setw(32) <<func_name  << " : " << counter / (double)time_cost * 1000*1000 << " op/s"<< " total:" << counter << " timecost:" << time_cost << " μs"<<std::endl;
+}
+DEFINE_string(type, "", "");
+DEFINE_string(prefix_seek, "1", "param for prefix seek");
+DEFINE_string(path, "testdb", "db path");
+DEFINE_uint64(count, 1000000, " write count");
+DEFINE_uint64(read_count, 1000000, "random read counts");
+DEFINE_uint64(db_size, 1, "db size in disk, GB");
+DEFINE_uint64(db_size_mb, 0, "initial map size in MB, overrides db_size when set");
+DEFINE_uint64(map_max_size, 0, "grow the map on MDB_MAP_FULL up to this many GB, 0 keeps it fixed");
+DEFINE_double(map_grow_factor, 2, "map growth factor, each step adds at least 64MB");
+DEFINE_bool(map_preallocate, false, "fallocate the range added by each map growth");
+DEFINE_uint32(uring_depth, 0, "write commits through an io_uring keeping this many runs in flight, 0 uses pwritev");
+DEFINE_uint64(txn_dirty_max, 0, "dirty pages a write txn holds before spilling, 0 keeps the 2^17 default");
+DEFINE_uint32(alloc_rounds, 20, "overwrite txns in alloc_latency");
+DEFINE_uint32(commit_rounds, 4, "commits per mode and txn size in commit_latency");
+DEFINE_bool(print, false, "print result");
+DEFINE_uint64(batch_size, 0, "rows per write_batch call in bulk_load, 0 means the whole input");
+DEFINE_uint32(max_readers, 100, "reader table slots, see mdb_env_set_maxreaders");
+DEFINE_bool(notls, false, "open env with MDB_NOTLS");
+DEFINE_uint32(threads, 0, "max threads for parallel tests, 0 means omp_get_max_threads()");
+DEFINE_uint64(renew_interval, 0, "reset/renew the per-thread read txn every N ops, 0 disables");
+DEFINE_uint32(int_key_bits, 64, "key width of the int_* and dupfixed tests, 32 or 64");
+DEFINE_bool(dup_integer, true, "dupfixed_search stores MDB_INTEGERDUP items, otherwise big endian memcmp items");
+DEFINE_string(key_prefix, "", "prefix prepended to the keys of write and random_read");
+DEFINE_bool(short_sep, false, "create db1 with MDB_SHORTSEP");
+DEFINE_bool(warmup, false, "warm up the branch pages after opening the env");
+DEFINE_bool(warmup_lock, false, "mlock the branch pages while warming up");
+DEFINE_string(readahead, "", "env readahead policy: normal, random or sequential");
+DEFINE_uint32(iter_readahead, 0, "leaf pages iter keeps advised ahead, 0 disables");
+DEFINE_bool(evict, false, "drop the env from the page cache before the test");
+DEFINE_bool(latency, false, "record per op latency histogram");
+DEFINE_string(latency_format, "text", "latency report format: text, csv or json");
+DEFINE_string(latency_out, "", "append latency report to this file instead of stdout");
+DEFINE_bool(sync, false, "open env without MDB_NOSYNC, every commit is fsynced");
+DEFINE_uint64(group_max_ops, 1024, "ops per group commit of the write coordinator");
+DEFINE_uint64(group_max_latency_us, 0, "time the write coordinator waits to fill a group");
+DEFINE_uint32(async_tasks, 4, "coroutines per worker in async_read");
+DEFINE_uint64(dup_items, 1000, "items per key in multi_value");
+DEFINE_uint64(key_window, 0, "multi_get draws each batch from this many consecutive ids, 0 means all");
+DEFINE_uint32(scan_parts, 1, "ranges per thread in iter_parallel, more evens out skew");
+DEFINE_uint32(range_digits, 2, "trailing digits cut off a random key to get a range_scan prefix");
+DEFINE_uint64(range_limit, 0, "max rows per range in range_scan, 0 means all");
+
+void print_latency(const char* func_name, const LatencyHistogram& hist){
+    std::ofstream file;
+    if(!FLAGS_latency_out.empty()){
+        file.open(FLAGS_latency_out, ios::app);
+    }
+    std::ostream& out = file.is_open() ? file : std::cout;
+    if(FLAGS_latency_format == "csv"){
+        static bool header_printed = false;
+        if(!header_printed){
+            out << "name,count,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns" << std::endl;
+            header_printed = true;
+        }
+        out << func_name << "," << hist.count() << "," << hist.min() << "," << hist.percentile(50)
+            << "," << hist.percentile(90) << "," << hist.percentile(99) << ","
+            << hist.percentile(99.9) << "," << hist.max() << std::endl;
+    }else if(FLAGS_latency_format == "json"){
+        out << "{\"name\":\"" << func_name << "\",\"count\":" << hist.count()
+            << ",\"min_ns\":" << hist.min() << ",\"p50_ns\":" << hist.percentile(50)
+            << ",\"p90_ns\":" << hist.percentile(90) << ",\"p99_ns\":" << hist.percentile(99)
+            << ",\"p999_ns\":" << hist.percentile(99.9) << ",\"max_ns\":" << hist.max() << "}" << std::endl;
+    }else{
+        out.setf(ios::left);
+        out << std::setw(32) << func_name << " : latency ns p50:" << hist.percentile(50)
+            << " p90:" << hist.percentile(90) << " p99:" << hist.percentile(99)
+            << " p99.9:" << hist.percentile(99.9) << " max:" << hist.max()
+            << " count:" << hist.count() << std::endl;
+    }
+}
+void write_test(DBEnv& db_env){
+    auto start = std::chrono::high_resolution_clock::now();
+
+    DBInstance db_ins;
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    KeyEncoder<256> encoder;
+    size_t counter = 0;
+    MDB_stat db_stat;
+    MDB_dirty_stat dirty_stat;
+    //with --map_max_size a MDB_MAP_FULL grows the map and the whole txn runs again
+    CHECK_MDB(db_env.write_txn([&](Transaction &txn){
+        db_ins.init(txn,"db1",MDB_CREATE|(FLAGS_short_sep ? MDB_SHORTSEP : 0));
+        hist = LatencyHistogram();
+        counter = 0;
+        for(std::size_t i = 0; i < FLAGS_count; ++i){
+            Slice key = encoder.clear().append(FLAGS_key_prefix).append_decimal(i).slice();
+            int ret;
+            {
+                ScopedLatency timer(hist_ptr);
+                ret = db_ins.write(txn,key,key);
+            }
+            if(ret == 0){
+                ++counter;
+            }else if(ret == MDB_MAP_FULL){
+                return ret;
+            }
+        }
+        int ret = txn.dirty_stat(dirty_stat);
+        return ret ? ret : db_ins.stat(txn, db_stat);
+    }));
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,counter);
+    std::cout << std::setw(32) << "" << " : depth:" << db_stat.ms_depth << " branch_pages:"
+              << db_stat.ms_branch_pages << " leaf_pages:" << db_stat.ms_leaf_pages << std::endl;
+    std::cout << std::setw(32) << "" << " : dirty_peak:" << dirty_stat.ds_peak << " dirty_max:"
+              << dirty_stat.ds_max << " spills:" << dirty_stat.ds_spills << " spilled_pages:"
+              << dirty_stat.ds_spilled << " unspilled_pages:" << dirty_stat.ds_unspilled << std::endl;
+    if(db_env.map_resizes()){
+        std::cout << std::setw(32) << "" << " : map_resizes:" << db_env.map_resizes() << " map_size:"
+                  << (db_env.map_size() >> 20) << "MB" << std::endl;
+    }
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+    db_ins.close(db_env);
+}
+
+void bulk_load_test(DBEnv& db_env){
+    vector<pair<string, string>> rows;
+    rows.reserve(FLAGS_count);
+    for(std::size_t i = 0; i < FLAGS_count; ++i){
+        rows.emplace_back(to_string(i), to_string(i));
+    }
+    auto clear_db = [&](const string& db_name){
+        auto txn = db_env.new_transaction();
+        DBInstance db_ins;
+        db_ins.init(txn, db_name);
+        db_ins.drop(txn);
+        txn.commit();
+    };
+
+    clear_db("bulk_put");
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto txn = db_env.new_transaction();
+        DBInstance db_ins;
+        db_ins.init(txn, "bulk_put");
+        size_t counter = 0;
+        for(auto& row : rows){
+            if(db_ins.write(txn, row.first, row.second) == 0){
+                ++counter;
+            }
+        }
+        txn.commit();
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats("bulk_load_test(write)", time_cost, counter);
+        db_ins.close(db_env);
+    }
+
+    clear_db("bulk_batch");
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto txn = db_env.new_transaction();
+        DBInstance db_ins;
+        db_ins.init(txn, "bulk_batch");
+        size_t batch_size = FLAGS_batch_size ? FLAGS_batch_size : rows.size();
+        size_t counter = 0;
+        for(size_t pos = 0; pos < rows.size(); pos += batch_size){
+            // a view of the prepared rows, copying them would be timed as well
+            std::span<const pair<string, string>> batch(rows.data() + pos, std::min(batch_size, rows.size() - pos));
+            size_t written = 0;
+            CHECK_MDB(db_ins.write_batch(txn, batch, MDB_NOOVERWRITE, &written));
+            counter += written;
+        }
+        txn.commit();
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats("bulk_load_test(write_batch)", time_cost, counter);
+        db_ins.close(db_env);
+    }
+}
+
+void iter_test(DBEnv& db_env){
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    DBInstance db_ins;
+    db_ins.init(new_txn,"db1");
+
+
+    auto iter = db_ins.new_iterator(new_txn);
+    iter.set_readahead(FLAGS_iter_readahead);
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    size_t counter = 0;
+    for(iter.seek_first();iter.valid();){
+        ++counter;
+        ScopedLatency timer(hist_ptr);
+        iter.next();
+    }
+    iter.close();
+    new_txn.abort();
+
+    db_ins.close(db_env);
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,counter);
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+}
+
+void iter_parallel_test(DBEnv& db_env){
+    //full scan cut into ranges by branch separators, one read txn per thread on one snapshot
+    DBInstance db_ins;
+    {
+        auto txn = db_env.new_transaction(MDB_RDONLY);
+        db_ins.init(txn,"db1");
+        txn.commit();
+    }
+
+    unsigned int max_threads = FLAGS_threads ? FLAGS_threads : omp_get_max_threads();
+    if(max_threads > db_env.max_readers()){
+        std::cout << "threads:" << max_threads << " exceed max_readers:" << db_env.max_readers() << std::endl;
+        max_threads = db_env.max_readers();
+    }
+    vector<unsigned int> thread_steps;
+    for(unsigned int t = 1; t < max_threads; t <<= 1){
+        thread_steps.push_back(t);
+    }
+    thread_steps.push_back(max_threads);
+
+    double single_thread_ops = 0;
+    size_t single_thread_rows = 0;
+    for(auto threads : thread_steps){
+        unsigned int parts = threads * FLAGS_scan_parts;
+        vector<size_t> part_rows(parts, 0);
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t counter = 0;
+        CHECK_MDB(db_ins.parallel_scan(db_env, threads, [&](size_t part, Slice, Slice){
+            ++part_rows[part];
+        }, counter, parts));
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+        double total_ops = counter / (double)time_cost * 1000*1000;
+        if(threads == 1){
+            single_thread_ops = total_ops;
+            single_thread_rows = counter;
+        }
+        auto minmax = std::minmax_element(part_rows.begin(), part_rows.end());
+        string name = string(__FUNCTION__) + "(threads=" + to_string(threads) + ")";
+        print_stats(name.c_str(), time_cost, counter);
+        std::cout << std::setw(32) << "" << " : parts:" << parts << " rows min:" << *minmax.first
+                  << " max:" << *minmax.second << " speedup:" << total_ops / single_thread_ops
+                  << " efficiency:" << total_ops / (single_thread_ops * threads) * 100 << "%" << std::endl;
+        if(counter != single_thread_rows){
+            std::cout << name << " rows:" << counter << " differ from single thread:" << single_thread_rows << std::endl;
+        }
+    }
+    db_ins.close(db_env);
+}
+void rand_read_test(DBEnv& db_env){
+    //rand read
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    DBInstance db_ins;
+    db_ins.init(new_txn,"db1");
+
+
+    auto iter = db_ins.new_iterator(new_txn);
+    size_t counter = 0;
+    std::random_device rd;  // 将用于为随机数引擎获得种子
+    std::mt19937 gen(rd()); // 以播种标准 mersenne_twister_engine
+    std::uniform_int_distribution<> dis(0, FLAGS_count-1);
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    KeyEncoder<256> encoder;
+    for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
+        Slice key = encoder.clear().append(FLAGS_key_prefix).append_decimal(dis(gen)).slice();
+        Slice out_value;
+        bool found;
+        {
+            ScopedLatency timer(hist_ptr);
+            found = db_ins.get(new_txn, key, out_value);
+        }
+        if (found) {
+            ++counter;
+        }
+    }
+    iter.close();
+    new_txn.abort();
+    db_ins.close(db_env);
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,counter);
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+}
+
+int my_rand(const int & min, const int & max) {
+    static thread_local std::mt19937 generator;
+    std::uniform_int_distribution<int> distribution(min,max);
+    return distribution(generator);
+}
+
+void rand_parallel_read_test(DBEnv& db_env){
+    //rand read
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    DBInstance db_ins;
+    db_ins.init(new_txn,"db1");
+
+
+    auto iter = db_ins.new_iterator(new_txn);
+//    size_t counter = 0;
+//    std::random_device rd;  // 将用于为随机数引擎获得种子
+//    std::mt19937 gen(rd()); // 以播种标准 mersenne_twister_engine
+//    std::uniform_int_distribution<> dis(0, FLAGS_count);
+    vector<LatencyHistogram> thread_hists(FLAGS_latency ? omp_get_max_threads() : 0);
+#pragma omp parallel for
+    for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
+        static thread_local KeyEncoder<> encoder;
+        Slice key = encoder.clear().append_decimal(my_rand(0,FLAGS_count)).slice();
+        Slice out_value;
+        bool found;
+        {
+            ScopedLatency timer(FLAGS_latency ? &thread_hists[omp_get_thread_num()] : nullptr);
+            found = db_ins.get(new_txn, key, out_value);
+        }
+        if (found) {
+            if(FLAGS_print){
+                std::cout << "get key:" << key.to_string_view()<<" value :" <<out_value.to_string() << std::endl;
+            }
+//            ++counter;
+        }
+    }
+    iter.close();
+    new_txn.abort();
+    db_ins.close(db_env);
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,FLAGS_read_count);
+    if(FLAGS_latency){
+        LatencyHistogram hist;
+        for(auto& thread_hist : thread_hists){
+            hist.merge(thread_hist);
+        }
+        print_latency(__FUNCTION__,hist);
+    }
+}
+
+void rand_read_thread_txn_test(DBEnv& db_env){
+    //rand read, every thread owns its read txn
+    DBInstance db_ins;
+    {
+        auto txn = db_env.new_transaction(MDB_RDONLY);
+        db_ins.init(txn,"db1");
+        txn.commit();
+    }
+
+    unsigned int max_threads = FLAGS_threads ? FLAGS_threads : omp_get_max_threads();
+    if(max_threads > db_env.max_readers()){
+        std::cout << "threads:" << max_threads << " exceed max_readers:" << db_env.max_readers() << std::endl;
+        max_threads = db_env.max_readers();
+    }
+    vector<unsigned int> thread_steps;
+    for(unsigned int t = 1; t < max_threads; t <<= 1){
+        thread_steps.push_back(t);
+    }
+    thread_steps.push_back(max_threads);
+
+    double single_thread_ops = 0;
+    for(auto threads : thread_steps){
+        vector<double> thread_ops(threads, 0);
+        vector<LatencyHistogram> thread_hists(FLAGS_latency ? threads : 0);
+        size_t ops_per_thread = FLAGS_read_count / threads;
+        auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+        {
+            auto thread_start = std::chrono::high_resolution_clock::now();
+            auto txn = db_env.new_transaction(MDB_RDONLY);
+            KeyEncoder<> encoder;
+            size_t counter = 0;
+            for (std::size_t i = 0; i < ops_per_thread; ++i) {
+                if(FLAGS_renew_interval && i && i % FLAGS_renew_interval == 0){
+                    txn.reset();
+                    CHECK_MDB(txn.renew());
+                }
+                Slice key = encoder.clear().append_decimal(my_rand(0,FLAGS_count-1)).slice();
+                Slice out_value;
+                bool found;
+                {
+                    ScopedLatency timer(FLAGS_latency ? &thread_hists[omp_get_thread_num()] : nullptr);
+                    found = db_ins.get(txn, key, out_value);
+                }
+                if (found) {
+                    ++counter;
+                }
+            }
+            txn.abort();
+            auto thread_elapsed = std::chrono::high_resolution_clock::now() - thread_start;
+            auto thread_cost = std::chrono::duration_cast<std::chrono::microseconds>(thread_elapsed).count();
+            thread_ops[omp_get_thread_num()] = counter / (double)thread_cost * 1000*1000;
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+        double total_ops = ops_per_thread * threads / (double)time_cost * 1000*1000;
+        if(threads == 1){
+            single_thread_ops = total_ops;
+        }
+        auto minmax = std::minmax_element(thread_ops.begin(), thread_ops.end());
+        double avg = 0;
+        for(auto ops : thread_ops){
+            avg += ops / threads;
+        }
+        string name = string(__FUNCTION__) + "(threads=" + to_string(threads) + ")";
+        print_stats(name.c_str(), time_cost, ops_per_thread * threads);
+        std::cout << std::setw(32) << "" << " : per thread avg:" << avg << " min:" << *minmax.first
+                  << " max:" << *minmax.second << " op/s efficiency:"
+                  << total_ops / (single_thread_ops * threads) * 100 << "%" << std::endl;
+        if(FLAGS_print){
+            for(unsigned int t = 0; t < threads; ++t){
+                std::cout << std::setw(32) << "" << " : thread " << t << " " << thread_ops[t] << " op/s" << std::endl;
+            }
+        }
+        if(FLAGS_latency){
+            LatencyHistogram hist;
+            for(auto& thread_hist : thread_hists){
+                hist.merge(thread_hist);
+            }
+            print_latency(name.c_str(), hist);
+        }
+    }
+    db_ins.close(db_env);
+}
+template <typename T>
+void int_write_test(DBEnv& db_env){
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto txn = db_env.new_transaction();
+
+    IntDBInstance<T> db_ins;
+    db_ins.init(txn,"db1_int");
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    KeyEncoder<> encoder;
+    size_t counter = 0;
+    for(std::size_t i = 0; i < FLAGS_count; ++i){
+        Slice value = encoder.clear().append_decimal(i).slice();
+        int ret;
+        {
+            ScopedLatency timer(hist_ptr);
+            ret = db_ins.write(txn,(T)i,value);
+        }
+        if(ret == 0){
+            ++counter;
+        }
+    }
+    txn.commit();
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,counter);
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+    db_ins.close(db_env);
+}
+
+template <typename T>
+void int_rand_read_test(DBEnv& db_env){
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    IntDBInstance<T> db_ins;
+    db_ins.init(new_txn,"db1_int");
+
+    size_t counter = 0;
+    std::mt19937_64 gen(std::random_device{}());
+    std::uniform_int_distribution<uint64_t> dis(0, FLAGS_count-1);
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
+        T key = (T)dis(gen);
+        Slice out_value;
+        bool found;
+        {
+            ScopedLatency timer(hist_ptr);
+            found = db_ins.get(new_txn, key, out_value);
+        }
+        if (found) {
+            ++counter;
+        }
+    }
+    new_txn.abort();
+
+    db_ins.close(db_env);
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,counter);
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+}
+
+template <typename T>
+void int_iter_test(DBEnv& db_env){
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    IntDBInstance<T> db_ins;
+    db_ins.init(new_txn,"db1_int");
+
+    auto iter = db_ins.new_iterator(new_txn);
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    size_t counter = 0;
+    T key_sum = 0;
+    for(iter.seek_first();iter.valid();){
+        key_sum += IntDBInstance<T>::key_of(iter.key());
+        ++counter;
+        ScopedLatency timer(hist_ptr);
+        iter.next();
+    }
+    iter.close();
+    new_txn.abort();
+    db_ins.close(db_env);
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats(__FUNCTION__,time_cost,counter);
+    if(FLAGS_print){
+        std::cout << "key sum:" << key_sum << std::endl;
+    }
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+}
+
+// lookups inside one MDB_DUPFIXED key, its sub-db is made of LEAF2 pages of packed items
+template <typename T>
+void dupfixed_search_test(DBEnv& db_env){
+    unsigned int db_flag = MDB_CREATE|MDB_DUPSORT|MDB_DUPFIXED;
+    string db_name = "db1_dupfixed";
+    if(FLAGS_dup_integer){
+        db_flag |= MDB_INTEGERDUP;
+        db_name += "_int";
+    }
+    auto encode = [](KeyEncoder<>& encoder, uint64_t value) {
+        encoder.clear();
+        if(FLAGS_dup_integer){
+            T item = (T)value;
+            return encoder.append(Slice((const char*)&item, sizeof(T))).slice();
+        }
+        return sizeof(T) == 4 ? encoder.append_fixed32((uint32_t)value).slice()
+                              : encoder.append_fixed64((uint64_t)value).slice();
+    };
+    KeyEncoder<> encoder;
+    {
+        auto txn = db_env.new_transaction();
+        DBInstance db_ins;
+        db_ins.init(txn, db_name, db_flag);
+        db_ins.drop(txn);
+        for(std::size_t i = 0; i < FLAGS_count; ++i){
+            // only even items are stored so half of the lookups miss
+            CHECK_MDB(db_ins.write(txn, "dup", encode(encoder, i * 2), MDB_APPENDDUP));
+        }
+        txn.commit();
+        db_ins.close(db_env);
+    }
+
+    int last_level = -1;
+    for(int level : {MDB_SIMD_NONE, MDB_SIMD_SSE42, MDB_SIMD_AVX2}){
+        level = mdb_set_simd(level);
+        if(level == last_level){
+            continue;
+        }
+        last_level = level;
+        auto start = std::chrono::high_resolution_clock::now();
+        auto txn = db_env.new_transaction(MDB_RDONLY);
+        DBInstance db_ins;
+        db_ins.init(txn, db_name, db_flag & ~MDB_CREATE);
+        auto iter = db_ins.new_iterator(txn);
+        std::mt19937_64 gen(42);
+        std::uniform_int_distribution<uint64_t> dis(0, FLAGS_count * 2 - 1);
+        LatencyHistogram hist;
+        auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+        size_t counter = 0;
+        for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
+            Slice item = encode(encoder, dis(gen));
+            ScopedLatency timer(hist_ptr);
+            if(iter.get_both("dup", item)){
+                ++counter;
+            }
+        }
+        iter.close();
+        txn.abort();
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        const char* level_name[] = {"scalar", "sse4.2", "avx2"};
+        string name = string(__FUNCTION__) + "(" + level_name[level] + ")";
+        print_stats(name.c_str(), time_cost, FLAGS_read_count);
+        std::cout << std::setw(32) << "" << " : found:" << counter << std::endl;
+        if(FLAGS_latency){
+            print_latency(name.c_str(), hist);
+        }
+    }
+    mdb_set_simd(-1);
+}
+
+// one to many relations: per item put and MDB_NEXT_DUP stepping against MDB_MULTIPLE puts
+// and page wise MDB_GET_MULTIPLE reads, --count items spread over keys of --dup_items
+template <typename T>
+void multi_value_test(DBEnv& db_env){
+    size_t dup_items = std::max<size_t>(FLAGS_dup_items, 1);
+    size_t keys = std::max<size_t>(FLAGS_count / dup_items, 1);
+    vector<T> items(dup_items);
+    for(std::size_t i = 0; i < dup_items; ++i){
+        items[i] = (T)(i * 3);
+    }
+    KeyEncoder<> encoder;
+    for(bool bulk : {false, true}){
+        auto start = std::chrono::high_resolution_clock::now();
+        auto txn = db_env.new_transaction();
+        MultiDBInstance<T> db_ins;
+        db_ins.init(txn, "db1_multi");
+        db_ins.drop(txn);
+        size_t counter = 0;
+        for(std::size_t k = 0; k < keys; ++k){
+            Slice key = encoder.clear().append_decimal(k).slice();
+            if(bulk){
+                size_t written = 0;
+                CHECK_MDB(db_ins.put_multiple(txn, key, items.data(), items.size(), &written));
+                counter += written;
+            }else{
+                for(auto& item : items){
+                    if(db_ins.put(txn, key, item) == MDB_SUCCESS){
+                        ++counter;
+                    }
+                }
+            }
+        }
+        CHECK_MDB(txn.commit());
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats(bulk ? "multi_value_test(put_multiple)" : "multi_value_test(put)",time_cost,counter);
+    }
+
+    auto txn = db_env.new_transaction(MDB_RDONLY);
+    MultiDBInstance<T> db_ins;
+    db_ins.init(txn, "db1_multi", 0);
+    size_t read_keys = std::min<size_t>(FLAGS_read_count / dup_items + 1, keys);
+    vector<T> out;
+    out.reserve(dup_items);
+    for(bool bulk : {false, true}){
+        LatencyHistogram hist;
+        auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+        uint64_t sum = 0;
+        size_t counter = 0;
+        auto iter = db_ins.new_iterator(txn);
+        auto start = std::chrono::high_resolution_clock::now();
+        for(std::size_t i = 0; i < read_keys; ++i){
+            Slice key = encoder.clear().append_decimal(my_rand(0, keys - 1)).slice();
+            ScopedLatency timer(hist_ptr);
+            out.clear();
+            if(bulk){
+                CHECK_MDB(db_ins.get_all(txn, key, out));
+            }else if(iter.has_key(key)){
+                iter.seek_first(Iterator::FirstType::Dup);
+                for(; iter.valid(); iter.next(Iterator::NextType::Dup)){
+                    T item;
+                    memcpy(&item, iter.value().data(), sizeof(T));
+                    out.push_back(item);
+                }
+            }
+            counter += out.size();
+            for(auto item : out){
+                sum += item;
+            }
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        const char* name = bulk ? "multi_value_test(get_multiple)" : "multi_value_test(next_dup)";
+        print_stats(name,time_cost,counter);
+        if(FLAGS_print){
+            std::cout << std::setw(32) << "" << " : item sum:" << sum << std::endl;
+        }
+        if(FLAGS_latency){
+            print_latency(name,hist);
+        }
+    }
+    txn.abort();
+}
+
+// stand-in for a record serializer, writes size bytes derived from seed
+static void fill_record(char* out, size_t size, uint64_t seed){
+    uint64_t x = seed * 0x9E3779B97F4A7C15ULL + 1;
+    size_t i = 0;
+    for(; i + sizeof(x) <= size; i += sizeof(x)){
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        memcpy(out + i, &x, sizeof(x));
+    }
+    memset(out + i, 0, size - i);
+}
+
+// 1KB-64KB values, serialized into a buffer and copied by write against serialized in
+// place through write_reserve
+void reserve_write_test(DBEnv& db_env){
+    const size_t total_bytes = 256 << 20;
+    const size_t txn_bytes = 16 << 20;
+    KeyEncoder<> encoder;
+    string buffer;
+    for(size_t value_size : {1 << 10, 4 << 10, 16 << 10, 64 << 10}){
+        size_t rows = std::min<size_t>(FLAGS_count, total_bytes / value_size);
+        size_t rows_per_txn = std::max<size_t>(txn_bytes / value_size, 1);
+        buffer.resize(value_size);
+        for(bool reserve : {false, true}){
+            DBInstance db_ins;
+            {
+                auto txn = db_env.new_transaction();
+                db_ins.init(txn, "db1_reserve");
+                db_ins.drop(txn);
+                txn.commit();
+            }
+            size_t counter = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for(std::size_t first = 0; first < rows; first += rows_per_txn){
+                auto txn = db_env.new_transaction();
+                for(std::size_t i = first; i < std::min(rows, first + rows_per_txn); ++i){
+                    Slice key = encoder.clear().append_fixed64((uint64_t)i).slice();
+                    int ret;
+                    if(reserve){
+                        ret = db_ins.write_reserve(txn, key, value_size, [&](char* data, size_t size){
+                            fill_record(data, size, i);
+                        });
+                    }else{
+                        fill_record(&buffer[0], value_size, i);
+                        ret = db_ins.write(txn, key, buffer);
+                    }
+                    CHECK_MDB(ret);
+                    if(ret == MDB_SUCCESS){
+                        ++counter;
+                    }
+                }
+                CHECK_MDB(txn.commit());
+            }
+            auto elapsed = std::chrono::high_resolution_clock::now() - start;
+            int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+            string name = string(__FUNCTION__) + (reserve ? "(reserve," : "(write,") + to_string(value_size >> 10) + "KB)";
+            print_stats(name.c_str(),time_cost,counter);
+            std::cout << std::setw(32) << "" << " : " << counter * value_size / (double)time_cost << " MB/s" << std::endl;
+            db_ins.close(db_env);
+        }
+    }
+}
+
+// commit latency by txn size, pwritev against io_uring (DBEnv::set_uring). random keys into
+// a db emptied per size spread the dirty pages over reused page numbers; run with --sync to
+// include the data sync
+void commit_latency_test(DBEnv& db_env){
+    const size_t value_size = 1000;
+    unsigned int depth = FLAGS_uring_depth ? FLAGS_uring_depth : 64;
+    KeyEncoder<> encoder;
+    string value(value_size, 'v');
+    std::mt19937_64 gen(1);
+    for(size_t txn_mb : {1, 4, 16, 64}){
+        DBInstance db_ins;
+        {
+            auto txn = db_env.new_transaction();
+            db_ins.init(txn, "db1_commit");
+            db_ins.drop(txn);
+            txn.commit();
+        }
+        size_t rows = (txn_mb << 20) / value_size;
+        vector<LatencyHistogram> hists(2);
+        for(size_t round = 0; round < 2 * FLAGS_commit_rounds; ++round){
+            //alternate so both modes see the same db growth
+            bool uring = round & 1;
+            int ret = db_env.set_uring(uring ? depth : 0);
+            if(ret != MDB_SUCCESS){
+                std::cout << "io_uring unavailable: " << mdb_strerror(ret) << std::endl;
+                return;
+            }
+            auto txn = db_env.new_transaction();
+            for(size_t i = 0; i < rows; ++i){
+                Slice key = encoder.clear().append_fixed64(gen()).slice();
+                CHECK_MDB(db_ins.write(txn, key, value, 0));
+            }
+            {
+                ScopedLatency timer(&hists[uring]);
+                CHECK_MDB(txn.commit());
+            }
+        }
+        for(int uring : {0, 1}){
+            string name = string(__FUNCTION__) + (uring ? "(io_uring," : "(pwritev,") + to_string(txn_mb) + "MB)";
+            print_latency(name.c_str(), hists[uring]);
+        }
+        db_ins.close(db_env);
+    }
+    db_env.set_uring(FLAGS_uring_depth);
+}
+
+// update-heavy write txn: --count rows are loaded and committed, then one txn overwrites
+// --count random rows, dirtying pages all over the tree in random order (dirty list insert
+// cost), and does --read_count gets, every page of which is found in the txn's dirty list
+// (mdb_page_get hit cost), from the first --key_window rows if set. --txn_dirty_max keeps a
+// large txn from spilling. the txn is aborted
+void dirty_get_test(DBEnv& db_env){
+    const size_t value_size = 100;
+    KeyEncoder<> encoder;
+    string value(value_size, 'v');
+    std::mt19937_64 gen(1);
+    vector<uint64_t> ids(FLAGS_count);
+    for(auto &id : ids){
+        id = gen();
+    }
+    DBInstance db_ins;
+    {
+        auto txn = db_env.new_transaction();
+        db_ins.init(txn, "db1_dirty");
+        db_ins.drop(txn);
+        for(auto id : ids){
+            CHECK_MDB(db_ins.write(txn, encoder.clear().append_fixed64(id).slice(), value, 0));
+        }
+        CHECK_MDB(txn.commit());
+    }
+    std::uniform_int_distribution<size_t> dis(0, ids.size() - 1);
+    auto txn = db_env.new_transaction();
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < ids.size(); ++i){
+        CHECK_MDB(db_ins.write(txn, encoder.clear().append_fixed64(ids[dis(gen)]).slice(), value, 0));
+    }
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    print_stats("dirty_get_test(update)", std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), ids.size());
+
+    MDB_stat db_stat;
+    MDB_dirty_stat dirty_stat;
+    CHECK_MDB(db_ins.stat(txn, db_stat));
+    CHECK_MDB(txn.dirty_stat(dirty_stat));
+    //a small --key_window keeps the pages read in cache, leaving mostly the dirty list lookups
+    std::uniform_int_distribution<size_t> window(0, std::min<size_t>(FLAGS_key_window ? FLAGS_key_window : ids.size(), ids.size()) - 1);
+    size_t counter = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for(size_t i = 0; i < FLAGS_read_count; ++i){
+        Slice out_value;
+        if(db_ins.get(txn, encoder.clear().append_fixed64(ids[window(gen)]).slice(), out_value)){
+            ++counter;
+        }
+    }
+    elapsed = std::chrono::high_resolution_clock::now() - start;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    print_stats("dirty_get_test(get)", ns / 1000, counter);
+    std::cout << std::setw(32) << "" << " : depth:" << db_stat.ms_depth << " dirty_pages:" << dirty_stat.ds_dirty
+              << " spilled_pages:" << dirty_stat.ds_spilled << " ns/get:" << (FLAGS_read_count ? ns / FLAGS_read_count : 0)
+              << std::endl;
+    txn.abort();
+    db_ins.close(db_env);
+}
+
+// put latency by value size while values of mixed sizes are overwritten, so overflow values
+// are placed in runs of free pages from the freeDB. --count keys are loaded, then each of
+// --alloc_rounds txns overwrites a quarter of them with a new random size. page growth
+// after the load is file growth the freelist could not absorb
+void alloc_latency_test(DBEnv& db_env){
+    const size_t value_sizes[] = {100, 2000, 16000, 100000, 400000};
+    const size_t classes = sizeof(value_sizes) / sizeof(value_sizes[0]);
+    KeyEncoder<> encoder;
+    string value(value_sizes[classes - 1], 'v');
+    std::mt19937_64 gen(1);
+    std::uniform_int_distribution<size_t> key_dis(0, FLAGS_count - 1), size_dis(0, classes - 1);
+    DBInstance db_ins;
+    {
+        auto txn = db_env.new_transaction();
+        db_ins.init(txn, "db1_alloc");
+        db_ins.drop(txn);
+        for(size_t i = 0; i < FLAGS_count; ++i){
+            Slice key = encoder.clear().append_fixed64(i).slice();
+            CHECK_MDB(db_ins.write(txn, key, Slice(value.data(), value_sizes[size_dis(gen)]), 0));
+        }
+        CHECK_MDB(txn.commit());
+    }
+    size_t loaded_pgno = db_env.last_pgno();
+    vector<LatencyHistogram> hists(classes);
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t round = 0; round < FLAGS_alloc_rounds; ++round){
+        auto txn = db_env.new_transaction();
+        for(size_t i = 0; i < FLAGS_count / 4; ++i){
+            Slice key = encoder.clear().append_fixed64(key_dis(gen)).slice();
+            size_t size_class = size_dis(gen);
+            ScopedLatency timer(&hists[size_class]);
+            CHECK_MDB(db_ins.write(txn, key, Slice(value.data(), value_sizes[size_class]), 0));
+        }
+        CHECK_MDB(txn.commit());
+    }
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    print_stats(__FUNCTION__, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+                FLAGS_alloc_rounds * (FLAGS_count / 4));
+    for(size_t c = 0; c < classes; ++c){
+        string name = string(__FUNCTION__) + "(" + to_string(value_sizes[c]) + "B)";
+        print_latency(name.c_str(), hists[c]);
+    }
+    std::cout << std::setw(32) << "" << " : pages after load:" << loaded_pgno << " after overwrites:"
+              << db_env.last_pgno() << std::endl;
+    db_ins.close(db_env);
+}
+
+// random point lookups in batches of 1..1024 keys, get per key against multi_get (sorted,
+// one cursor) and get_batch (interleaved descents). --key_window clusters each batch the
+// way related keys of one request are
+void multi_get_test(DBEnv& db_env){
+    auto txn = db_env.new_transaction(MDB_RDONLY);
+    DBInstance db_ins;
+    db_ins.init(txn,"db1");
+    for(size_t batch_size = 1; batch_size <= 1024; batch_size *= 4){
+        size_t batches = std::max<size_t>(FLAGS_read_count / batch_size, 1);
+        vector<string> keys(batch_size);
+        vector<Slice> key_slices(batch_size), values;
+        for(const char* mode : {"get", "multi_get", "get_batch"}){
+            LatencyHistogram hist;
+            auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+            size_t counter = 0;
+            std::chrono::nanoseconds elapsed{0};
+            size_t window = FLAGS_key_window && FLAGS_key_window < FLAGS_count ? FLAGS_key_window : FLAGS_count;
+            for(std::size_t b = 0; b < batches; ++b){
+                size_t base = my_rand(0, FLAGS_count - window);
+                for(std::size_t i = 0; i < batch_size; ++i){
+                    keys[i] = FLAGS_key_prefix + to_string(base + my_rand(0,window-1));
+                    key_slices[i] = keys[i];
+                }
+                auto start = std::chrono::high_resolution_clock::now();
+                {
+                    ScopedLatency timer(hist_ptr);
+                    if(mode == string("multi_get")){
+                        counter += db_ins.multi_get(txn, key_slices, values);
+                    }else if(mode == string("get_batch")){
+                        counter += db_ins.get_batch(txn, key_slices, values);
+                    }else{
+                        for(auto& key : key_slices){
+                            Slice out_value;
+                            if(db_ins.get(txn, key, out_value)){
+                                ++counter;
+                            }
+                        }
+                    }
+                }
+                elapsed += std::chrono::high_resolution_clock::now() - start;
+            }
+            int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+            string name = string(__FUNCTION__) + "(" + mode + "," + to_string(batch_size) + ")";
+            print_stats(name.c_str(),time_cost,counter);
+            if(FLAGS_latency){
+                print_latency(name.c_str(),hist);
+            }
+        }
+    }
+    txn.abort();
+}
+
+// random reads right after dropping the cache, then again after warming the branch pages
+void cold_warm_read_test(DBEnv& db_env){
+    auto read_round = [&](const char* name){
+        auto start = std::chrono::high_resolution_clock::now();
+        auto txn = db_env.new_transaction(MDB_RDONLY);
+        DBInstance db_ins;
+        db_ins.init(txn,"db1");
+        std::mt19937 gen(std::random_device{}());
+        std::uniform_int_distribution<> dis(0, FLAGS_count-1);
+        LatencyHistogram hist;
+        KeyEncoder<256> encoder;
+        size_t counter = 0;
+        for (std::size_t i = 0; i < FLAGS_read_count; ++i) {
+            Slice key = encoder.clear().append(FLAGS_key_prefix).append_decimal(dis(gen)).slice();
+            Slice out_value;
+            ScopedLatency timer(&hist);
+            if (db_ins.get(txn, key, out_value)) {
+                ++counter;
+            }
+        }
+        txn.abort();
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats(name,time_cost,counter);
+        print_latency(name,hist);
+    };
+
+    db_env.evict_cache();
+    read_round("cold_warm_read_test(cold)");
+
+    db_env.evict_cache();
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t pages = db_env.warmup(FLAGS_warmup_lock);
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    print_stats("cold_warm_read_test(warmup)",time_cost,pages);
+    read_round("cold_warm_read_test(warm)");
+}
+
+// cost of an empty read txn, mdb_txn_begin/abort against the per-thread pool
+void txn_pool_test(DBEnv& db_env){
+    unsigned int threads = FLAGS_threads ? FLAGS_threads : omp_get_max_threads();
+    size_t ops_per_thread = FLAGS_read_count / threads;
+    for(bool pooled : {false, true}){
+        vector<LatencyHistogram> thread_hists(FLAGS_latency ? threads : 0);
+        auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+        {
+            auto hist_ptr = FLAGS_latency ? &thread_hists[omp_get_thread_num()] : nullptr;
+            for (std::size_t i = 0; i < ops_per_thread; ++i) {
+                ScopedLatency timer(hist_ptr);
+                if(pooled){
+                    auto txn = db_env.read_txn();
+                }else{
+                    auto txn = db_env.new_transaction(MDB_RDONLY);
+                    txn.abort();
+                }
+            }
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        const char* name = pooled ? "txn_pool_test(pooled)" : "txn_pool_test(begin_abort)";
+        print_stats(name,time_cost,ops_per_thread * threads);
+        if(FLAGS_latency){
+            LatencyHistogram hist;
+            for(auto& thread_hist : thread_hists){
+                hist.merge(thread_hist);
+            }
+            print_latency(name,hist);
+        }
+    }
+}
+
+// --threads writers committing --batch_size puts each, own txn per batch against
+// the group committing WriteCoordinator
+void group_commit_test(DBEnv& db_env){
+    unsigned int threads = FLAGS_threads ? FLAGS_threads : omp_get_max_threads();
+    size_t batch_size = FLAGS_batch_size ? FLAGS_batch_size : 1;
+    size_t batches_per_thread = FLAGS_count / threads / batch_size;
+    DBInstance db_ins;
+    for(bool grouped : {false, true}){
+        {
+            auto txn = db_env.new_transaction();
+            db_ins.init(txn, "group_commit");
+            db_ins.drop(txn);
+            txn.commit();
+        }
+        unique_ptr<WriteCoordinator> coordinator;
+        if(grouped){
+            WriteCoordinator::Options options;
+            options.max_batch_ops = FLAGS_group_max_ops;
+            options.max_latency_us = FLAGS_group_max_latency_us;
+            coordinator.reset(new WriteCoordinator(db_env, options));
+        }
+        vector<LatencyHistogram> thread_hists(FLAGS_latency ? threads : 0);
+        std::atomic<size_t> counter{0};
+        auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+        {
+            unsigned int tid = omp_get_thread_num();
+            auto hist_ptr = FLAGS_latency ? &thread_hists[tid] : nullptr;
+            KeyEncoder<> encoder;
+            WriteBatch batch;
+            size_t written = 0;
+            for (std::size_t b = 0; b < batches_per_thread; ++b) {
+                size_t first = (tid * batches_per_thread + b) * batch_size;
+                ScopedLatency timer(hist_ptr);
+                int ret = MDB_SUCCESS;
+                if(grouped){
+                    batch.clear();
+                    for (std::size_t i = first; i < first + batch_size; ++i) {
+                        Slice key = encoder.clear().append_decimal(i).slice();
+                        batch.put(db_ins, key, key);
+                    }
+                    ret = coordinator->submit(std::move(batch)).get();
+                }else{
+                    auto txn = db_env.new_transaction();
+                    for (std::size_t i = first; ret == MDB_SUCCESS && i < first + batch_size; ++i) {
+                        Slice key = encoder.clear().append_decimal(i).slice();
+                        ret = db_ins.write(txn, key, key);
+                    }
+                    if(ret == MDB_SUCCESS){
+                        ret = txn.commit();
+                    }
+                }
+                CHECK_MDB(ret);
+                if(ret == MDB_SUCCESS){
+                    written += batch_size;
+                }
+            }
+            counter += written;
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        const char* name = grouped ? "group_commit_test(grouped)" : "group_commit_test(txn_per_batch)";
+        print_stats(name,time_cost,counter);
+        if(grouped){
+            auto stats = coordinator->stats();
+            std::cout << std::setw(32) << "" << " : commits:" << stats.commits
+                      << " batches/commit:" << stats.batches / (double)std::max<uint64_t>(stats.commits, 1) << std::endl;
+        }
+        if(FLAGS_latency){
+            LatencyHistogram hist;
+            for(auto& thread_hist : thread_hists){
+                hist.merge(thread_hist);
+            }
+            print_latency(name,hist);
+        }
+    }
+    db_ins.close(db_env);
+}
+
+#ifdef __cpp_impl_coroutine
+Task<void> async_reader(AsyncExecutor& executor, AsyncDB& db, size_t ops,
+                        std::atomic<size_t>& found, std::latch& done){
+    co_await executor.schedule();
+    KeyEncoder<> encoder;
+    size_t counter = 0;
+    for (std::size_t i = 0; i < ops; ++i) {
+        if (co_await db.get(encoder.clear().append_decimal(my_rand(0,FLAGS_count-1)).slice())) {
+            ++counter;
+        }
+    }
+    found += counter;
+    done.count_down();
+}
+
+Task<bool> async_get_one(AsyncDB& db, Slice key){
+    co_return (co_await db.get(key)).has_value();
+}
+
+// random reads, omp loop with a txn per thread against the coroutine facade: --async_tasks
+// coroutines per worker, and a plain caller thread whose every get hops to a worker and back
+void async_read_test(DBEnv& db_env){
+    unsigned int threads = FLAGS_threads ? FLAGS_threads : omp_get_max_threads();
+    DBInstance db_ins;
+    {
+        auto txn = db_env.new_transaction(MDB_RDONLY);
+        db_ins.init(txn,"db1");
+        txn.commit();
+    }
+    size_t tasks = threads * std::max(FLAGS_async_tasks, 1u);
+    size_t ops_per_task = FLAGS_read_count / tasks;
+    {
+        std::atomic<size_t> found{0};
+        size_t ops_per_thread = FLAGS_read_count / threads;
+        auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel num_threads(threads)
+        {
+            auto txn = db_env.new_transaction(MDB_RDONLY);
+            KeyEncoder<> encoder;
+            size_t counter = 0;
+            for (std::size_t i = 0; i < ops_per_thread; ++i) {
+                Slice out_value;
+                if (db_ins.get(txn, encoder.clear().append_decimal(my_rand(0,FLAGS_count-1)).slice(), out_value)) {
+                    ++counter;
+                }
+            }
+            found += counter;
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats("async_read_test(omp)",time_cost,found);
+    }
+    AsyncExecutor executor(db_env, threads);
+    WriteCoordinator writer(db_env);
+    AsyncDB async_db(executor, writer, db_ins);
+    {
+        std::atomic<size_t> found{0};
+        std::latch done(tasks);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t t = 0; t < tasks; ++t) {
+            spawn(async_reader(executor, async_db, ops_per_task, found, done));
+        }
+        done.wait();
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats("async_read_test(workers)",time_cost,found);
+    }
+    {
+        KeyEncoder<> encoder;
+        size_t found = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0; i < ops_per_task; ++i) {
+            if (sync_wait(async_get_one(async_db, encoder.clear().append_decimal(my_rand(0,FLAGS_count-1)).slice()))) {
+                ++found;
+            }
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats("async_read_test(caller)",time_cost,found);
+    }
+    db_ins.close(db_env);
+}
+#endif
+
+void prefix_seek_test(DBEnv& db_env, const string& seek_key){
+    //cursor seek
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    DBInstance db_ins;
+    db_ins.init(new_txn,"db1");
+
+
+    LatencyHistogram hist;
+    auto hist_ptr = FLAGS_latency ? &hist : nullptr;
+    size_t counter = 0;
+
+    RangeIterator iter;
+    {
+        ScopedLatency timer(hist_ptr);
+        iter = db_ins.new_range_iterator(new_txn, KeyRange::prefix(seek_key));
+    }
+    for (; iter.valid();) {
+        if(FLAGS_print){
+            std::cout << "value :" << iter.value().to_string_view() << std::endl;
+        }
+        ++counter;
+        ScopedLatency timer(hist_ptr);
+        iter.next();
+    }
+
+    iter.close();
+    new_txn.abort();
+    auto elapsed = std::chrono::high_resolution_clock::now() - start;
+    int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
     print_stats(__FUNCTION__,time_cost,counter);
+    if(FLAGS_latency){
+        print_latency(__FUNCTION__,hist);
+    }
+}
+
+void range_scan_test(DBEnv& db_env){
+    //prefix scans: seek and starts_with on every step against RangeIterator both ways
+    auto new_txn = db_env.new_transaction(MDB_RDONLY);
+    DBInstance db_ins;
+    db_ins.init(new_txn,"db1");
+
+    vector<string> prefixes(FLAGS_read_count);
+    for(auto& prefix : prefixes){
+        prefix = FLAGS_key_prefix + to_string(my_rand(0,FLAGS_count-1));
+        prefix.resize(std::max<size_t>(FLAGS_key_prefix.size() + 1, prefix.size() - std::min<size_t>(prefix.size(), FLAGS_range_digits)));
+    }
+
+    for(string mode : {"starts_with", "compare", "range", "range_reverse"}){
+        size_t counter = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        if(mode == "starts_with"){
+            auto iter = db_ins.new_iterator(new_txn);
+            for(auto& prefix : prefixes){
+                size_t rows = 0;
+                for(iter.seek_to(prefix); iter.valid() && iter.key().starts_with(prefix); iter.next()){
+                    if(FLAGS_range_limit && rows == FLAGS_range_limit){
+                        break;
+                    }
+                    ++rows;
+                }
+                counter += rows;
+            }
+        }else if(mode == "compare"){
+            //end key checked on every step, the generic bound without page granularity
+            auto iter = db_ins.new_iterator(new_txn);
+            for(auto& prefix : prefixes){
+                auto end = KeyRange::prefix_successor(prefix);
+                size_t rows = 0;
+                for(iter.seek_to(prefix); iter.valid() && (!end || db_ins.compare(new_txn, iter.key(), *end) < 0); iter.next()){
+                    if(FLAGS_range_limit && rows == FLAGS_range_limit){
+                        break;
+                    }
+                    ++rows;
+                }
+                counter += rows;
+            }
+        }else{
+            for(auto& prefix : prefixes){
+                auto range = KeyRange::prefix(prefix);
+                range.limit = FLAGS_range_limit;
+                range.reverse = mode == "range_reverse";
+                for(auto iter = db_ins.new_range_iterator(new_txn, std::move(range)); iter.valid(); iter.next()){
+                    ++counter;
+                }
+            }
+        }
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        string name = string(__FUNCTION__) + "(" + mode + ")";
+        print_stats(name.c_str(),time_cost,counter);
+    }
+    new_txn.abort();
+    db_ins.close(db_env);
 }
 
 int main(int argc, char *argv[]) {
     google::ParseCommandLineFlags(&argc, &argv, true);
-    DBEnv db_env(FLAGS_path, (1024*FLAGS_db_size) << 20);
+    unsigned int env_flag = MDB_FIXEDMAP|MDB_NOSYNC;
+    if(FLAGS_sync){
+        env_flag &= ~MDB_NOSYNC;
+    }
+    if(FLAGS_notls){
+        env_flag |= MDB_NOTLS;
+    }
+    if(FLAGS_map_max_size){
+        //a grown map may land elsewhere
+        env_flag &= ~MDB_FIXEDMAP;
+    }
+    DBEnv db_env(FLAGS_path, (FLAGS_db_size_mb ? FLAGS_db_size_mb : 1024*FLAGS_db_size) << 20, env_flag, FLAGS_max_readers);
+    if(FLAGS_map_max_size){
+        DBEnv::MapGrowth growth;
+        growth.max_size = (1024*FLAGS_map_max_size) << 20;
+        growth.factor = FLAGS_map_grow_factor;
+        growth.preallocate = FLAGS_map_preallocate;
+        CHECK_MDB(db_env.set_map_growth(growth));
+    }
+    if(FLAGS_uring_depth){
+        CHECK_MDB(db_env.set_uring(FLAGS_uring_depth));
+    }
+    if(FLAGS_txn_dirty_max){
+        CHECK_MDB(db_env.set_dirty_max(FLAGS_txn_dirty_max));
+    }
+    if(FLAGS_readahead == "normal"){
+        CHECK_MDB(db_env.set_readahead(DBEnv::Readahead::Normal));
+    }else if(FLAGS_readahead == "random"){
+        CHECK_MDB(db_env.set_readahead(DBEnv::Readahead::Random));
+    }else if(FLAGS_readahead == "sequential"){
+        CHECK_MDB(db_env.set_readahead(DBEnv::Readahead::Sequential));
+    }
+    if(FLAGS_evict){
+        db_env.evict_cache();
+    }
+    if(FLAGS_warmup){
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t pages = db_env.warmup(FLAGS_warmup_lock);
+        auto elapsed = std::chrono::high_resolution_clock::now() - start;
+        int time_cost = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        print_stats("warmup",time_cost,pages);
+    }
 
     if(FLAGS_type == "write"){
         write_test(db_env);
+    }else if(FLAGS_type == "bulk_load"){
+        bulk_load_test(db_env);
     }else if(FLAGS_type == "iter"){
         iter_test(db_env);
+    }else if(FLAGS_type == "iter_parallel"){
+        iter_parallel_test(db_env);
     }else if(FLAGS_type == "random_read"){
         rand_read_test(db_env);
     }else if(FLAGS_type == "random_read_parallel"){
         rand_parallel_read_test(db_env);
+    }else if(FLAGS_type == "random_read_thread_txn"){
+        rand_read_thread_txn_test(db_env);
+    }else if(FLAGS_type == "int_write"){
+        FLAGS_int_key_bits == 32 ? int_write_test<uint32_t>(db_env) : int_write_test<uint64_t>(db_env);
+    }else if(FLAGS_type == "int_random_read"){
+        FLAGS_int_key_bits == 32 ? int_rand_read_test<uint32_t>(db_env) : int_rand_read_test<uint64_t>(db_env);
+    }else if(FLAGS_type == "int_iter"){
+        FLAGS_int_key_bits == 32 ? int_iter_test<uint32_t>(db_env) : int_iter_test<uint64_t>(db_env);
+    }else if(FLAGS_type == "dupfixed_search"){
+        FLAGS_int_key_bits == 32 ? dupfixed_search_test<uint32_t>(db_env) : dupfixed_search_test<uint64_t>(db_env);
+    }else if(FLAGS_type == "multi_value"){
+        FLAGS_int_key_bits == 32 ? multi_value_test<uint32_t>(db_env) : multi_value_test<uint64_t>(db_env);
+    }else if(FLAGS_type == "reserve_write"){
+        reserve_write_test(db_env);
+    }else if(FLAGS_type == "multi_get"){
+        multi_get_test(db_env);
+    }else if(FLAGS_type == "cold_warm_read"){
+        cold_warm_read_test(db_env);
+    }else if(FLAGS_type == "txn_pool"){
+        txn_pool_test(db_env);
+    }else if(FLAGS_type == "group_commit"){
+        group_commit_test(db_env);
+#ifdef __cpp_impl_coroutine
+    }else if(FLAGS_type == "async_read"){
+        async_read_test(db_env);
+#endif
     }else if(FLAGS_type == "seek"){
         prefix_seek_test(db_env,FLAGS_prefix_seek);
+    }else if(FLAGS_type == "commit_latency"){
+        commit_latency_test(db_env);
+    }else if(FLAGS_type == "range_scan"){
+        range_scan_test(db_env);
+    }else if(FLAGS_type == "dirty_get"){
+        dirty_get_test(db_env);
+    }else if(FLAGS_type == "alloc_latency"){
+        alloc_latency_test(db_env);
     }
 
     return 0;